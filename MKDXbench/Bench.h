@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
+#include <streambuf>
+
+struct BenchOptions {
+    int iterations = 5;
+    std::string only;       // run just this size preset / scaling axis, empty = all
+    std::string tempDir;    // generated files go here
+};
+
+template <typename Fn>
+double TimeMs(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+inline double Median(std::vector<double> times)
+{
+    if (times.empty()) return 0;
+    std::sort(times.begin(), times.end());
+    return times[times.size() / 2];
+}
+
+// runs fn iterations times and returns the median in ms
+template <typename Fn>
+double MedianMs(int iterations, Fn&& fn)
+{
+    std::vector<double> times;
+    for (int i = 0; i < std::max(1, iterations); ++i)
+        times.push_back(TimeMs(fn));
+    return Median(times);
+}
+
+// the codec prints per node/file, swallow that while timing so the console isn't what we measure
+class QuietStdout {
+public:
+    QuietStdout() : previous(std::cout.rdbuf(&sink)) {}
+    ~QuietStdout() { std::cout.rdbuf(previous); }
+
+private:
+    struct NullBuffer : std::streambuf {
+        int overflow(int c) override { return c; }
+    } sink;
+    std::streambuf* previous;
+};
+
+inline double PerSecond(double amount, double ms) { return ms > 0 ? amount / (ms / 1000.0) : 0; }
+
+void RunBikeBench(const BenchOptions& options);
+void RunPatchBench(const BenchOptions& options);
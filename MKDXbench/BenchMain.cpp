@@ -0,0 +1,51 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <windows.h>
+
+#include "Bench.h"
+
+// globals the tool's sources expect (normally defined next to main in CoolStuff.cpp)
+std::string logPath;
+std::string exeDir;
+
+int main(int argc, char* argv[])
+{
+    std::cout << "\033[34mMKDX tool benchmarks\033[37m\n";
+
+    BenchOptions options;
+    std::string suite = "all";
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--iters=", 0) == 0) options.iterations = std::atoi(arg.c_str() + 8);
+        else if (arg.rfind("--only=", 0) == 0) options.only = arg.substr(7);
+        else if (arg == "bike" || arg == "patch" || arg == "all") suite = arg;
+        else {
+            std::cout << "Usage: MKDXbench [bike|patch|all] [--iters=N] [--only=<size or axis name>]\n";
+            return 1;
+        }
+    }
+
+    if (options.iterations < 1) options.iterations = 1;
+
+    char exePath[MAX_PATH];
+    GetModuleFileNameA(NULL, exePath, MAX_PATH);
+    std::string pathStr(exePath);
+    size_t pos = pathStr.find_last_of("\\/");
+    exeDir = (pos == std::string::npos) ? "." : pathStr.substr(0, pos);
+
+    char tempPath[MAX_PATH];
+    GetTempPathA(MAX_PATH, tempPath);
+    options.tempDir = std::string(tempPath) + "MKDXbench\\";
+    CreateDirectoryA(options.tempDir.c_str(), NULL);
+    logPath = options.tempDir + "message.log";
+    std::cout << "Generated files go to " << options.tempDir << "\n";
+
+    if (suite == "bike" || suite == "all")
+        RunBikeBench(options);
+    if (suite == "patch" || suite == "all")
+        RunPatchBench(options);
+
+    return 0;
+}
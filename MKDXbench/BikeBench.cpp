@@ -0,0 +1,137 @@
+#include <assimp/scene.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdio>
+
+#include "SaveFuncs.h"
+#include "Bench.h"
+#include "BikeGen.h"
+
+static std::vector<SynthModelParams> BikeSizePresets()
+{
+    std::vector<SynthModelParams> presets;
+
+    SynthModelParams tiny;
+    tiny.name = "tiny";
+    tiny.nodeCount = 16; tiny.meshNodeCount = 4; tiny.submeshesPerNode = 1; tiny.vertsPerSubmesh = 200;
+    presets.push_back(tiny);
+
+    SynthModelParams small;
+    small.name = "small";
+    small.nodeCount = 48; small.meshNodeCount = 12; small.submeshesPerNode = 2; small.vertsPerSubmesh = 1000;
+    presets.push_back(small);
+
+    // roughly a playable character
+    SynthModelParams medium;
+    medium.name = "medium";
+    medium.nodeCount = 128; medium.meshNodeCount = 24; medium.submeshesPerNode = 3; medium.vertsPerSubmesh = 3000;
+    medium.uvSets = 2; medium.linksPerMeshNode = 24; medium.skinnedBonesPerSubmesh = 6;
+    presets.push_back(medium);
+
+    // roughly a big course chunk
+    SynthModelParams large;
+    large.name = "large";
+    large.nodeCount = 512; large.meshNodeCount = 96; large.submeshesPerNode = 4; large.vertsPerSubmesh = 6000;
+    large.uvSets = 2; large.linksPerMeshNode = 32; large.skinnedBonesPerSubmesh = 6; large.materialCount = 32;
+    presets.push_back(large);
+
+    return presets;
+}
+
+static uint64_t FileSize(const std::string& path)
+{
+    std::ifstream fs(path, std::ios::binary | std::ios::ate);
+    return fs ? static_cast<uint64_t>(fs.tellg()) : 0;
+}
+
+static void PrintBenchRow(const char* label, double ms, double bytes, double verts)
+{
+    std::cout << "  " << std::left << std::setw(12) << label << std::right << std::fixed
+        << std::setw(10) << std::setprecision(2) << ms << " ms"
+        << std::setw(10) << std::setprecision(1) << PerSecond(bytes / (1024.0 * 1024.0), ms) << " MB/s"
+        << std::setw(10) << std::setprecision(2) << PerSecond(verts / 1000000.0, ms) << " Mverts/s\n";
+}
+
+void RunBikeBench(const BenchOptions& options)
+{
+    std::cout << "\n\033[34m--- BIKE codec ---\033[37m (median of " << options.iterations << ")\n";
+
+    for (const auto& params : BikeSizePresets()) {
+        if (!options.only.empty() && options.only != params.name) continue;
+
+        MKDXData model = GenerateSynthModel(params);
+        uint64_t verts = CountVertices(model);
+
+        // write the generated model once, that file is what the load benches read
+        std::string genPath = options.tempDir + params.name + ".bin";
+        std::string binPath = options.tempDir + params.name + "_out.bin";
+        {
+            QuietStdout quiet;
+            MKDXData copy = model;
+            SaveMKDXFile(genPath, options.tempDir, copy.headerData, copy.materialsData, copy.textureNames, copy.boneNames,
+                copy.nodeLinks, copy.allNodeNames, copy.rootNodes, copy.fullNodeDataList);
+        }
+        double bytes = static_cast<double>(FileSize(binPath));
+        if (bytes == 0) {
+            std::cerr << "failed to write " << binPath << ", skipping " << params.name << "\n";
+            continue;
+        }
+
+        std::cout << std::dec << "\n[" << params.name << "] " << params.nodeCount << " nodes, " << params.meshNodeCount << " mesh nodes x "
+            << params.submeshesPerNode << " submeshes x " << params.vertsPerSubmesh << " verts, " << params.uvSets << " uv sets, "
+            << (params.colors ? "colours, " : "") << params.linksPerMeshNode << " links, " << params.materialCount << " materials\n"
+            << "  " << verts << " verts, " << std::fixed << std::setprecision(2) << bytes / (1024.0 * 1024.0) << " MB\n";
+
+        std::vector<double> loadTimes, saveTimes, roundTripTimes, sceneTimes, normalsTimes;
+        std::string normalsBase = options.tempDir + params.name + "_sidecar";
+        std::string savePath = options.tempDir + params.name + "_save.bin";
+        std::string roundTripPath = options.tempDir + params.name + "_trip.bin";
+
+        {
+            QuietStdout quiet;
+            for (int i = 0; i < options.iterations; ++i) {
+                loadTimes.push_back(TimeMs([&] {
+                    std::ifstream fs(binPath, std::ios::binary);
+                    MKDXData loaded = LoadMKDXFile(fs);
+                }));
+
+                // the writer patches offsets into its inputs so every run gets a fresh copy
+                MKDXData copy = model;
+                saveTimes.push_back(TimeMs([&] {
+                    SaveMKDXFile(savePath, options.tempDir, copy.headerData, copy.materialsData, copy.textureNames, copy.boneNames,
+                        copy.nodeLinks, copy.allNodeNames, copy.rootNodes, copy.fullNodeDataList);
+                }));
+
+                roundTripTimes.push_back(TimeMs([&] {
+                    std::ifstream fs(binPath, std::ios::binary);
+                    MKDXData loaded = LoadMKDXFile(fs);
+                    SaveMKDXFile(roundTripPath, options.tempDir, loaded.headerData, loaded.materialsData, loaded.textureNames, loaded.boneNames,
+                        loaded.nodeLinks, loaded.allNodeNames, loaded.rootNodes, loaded.fullNodeDataList);
+                }));
+
+                std::ifstream fs(binPath, std::ios::binary);
+                MKDXData loaded = LoadMKDXFile(fs);
+                std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>> allMaterialToIndices;
+                aiScene* scene = nullptr;
+                sceneTimes.push_back(TimeMs([&] {
+                    scene = BuildExportScene(loaded.headerData, loaded.materialsData, loaded.textureNames, loaded.nodeLinks,
+                        loaded.allNodeNames, loaded.rootNodes, loaded.fullNodeDataList, true, allMaterialToIndices);
+                }));
+                // the Maya normals sidecar the exporter writes from that scene
+                normalsTimes.push_back(TimeMs([&] { WriteNormalsSidecar(normalsBase, scene); }));
+                delete scene;
+            }
+        }
+
+        PrintBenchRow("load", Median(loadTimes), bytes, static_cast<double>(verts));
+        PrintBenchRow("save", Median(saveTimes), bytes, static_cast<double>(verts));
+        PrintBenchRow("round-trip", Median(roundTripTimes), bytes * 2, static_cast<double>(verts));
+        PrintBenchRow("scene build", Median(sceneTimes), bytes, static_cast<double>(verts));
+        PrintBenchRow("normals", Median(normalsTimes), static_cast<double>(FileSize(normalsBase + "_normals.bin")), static_cast<double>(verts));
+        std::remove((normalsBase + "_normals.bin").c_str());
+        std::remove((normalsBase + "_normals.txt").c_str());
+    }
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+#include "BikeGen.h"
+
+MKDXData GenerateSynthModel(const SynthModelParams& params)
+{
+    MKDXData data;
+    std::mt19937 rng(params.seed);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_real_distribution<float> unit01(0.f, 1.f);
+
+    uint32_t nodeCount = std::max(1u, params.nodeCount);
+    uint32_t meshNodeCount = std::min(params.meshNodeCount, nodeCount);
+    uint32_t verts = std::min(std::max(3u, params.vertsPerSubmesh), 65535u);
+    uint32_t uvSets = std::min(params.uvSets, 4u);
+    uint32_t linkCount = std::min(params.linksPerMeshNode, std::min(32u, nodeCount));
+    uint32_t skinnedCount = std::min(std::min(params.skinnedBonesPerSubmesh, 6u), linkCount);
+    uint32_t materialCount = std::max(1u, params.materialCount);
+
+    // materials + one texture each
+    for (uint32_t i = 0; i < materialCount; ++i) {
+        Material m;
+        m.Diffuse = { 0.5f, 0.5f, 0.5f, 1.f };
+        m.Specular = { 0.7f, 0.7f, 0.7f, 1.f };
+        m.Ambience = { 1.f, 1.f, 1.f, 1.f };
+        m.Shiny = 1.f;
+        m.TextureIndices[0] = static_cast<int16_t>(i);
+        data.materialsData.push_back(m);
+        data.textureNames.push_back({ params.name + "_tex" + std::to_string(i) + ".dds", 0 });
+    }
+
+    // node tree, node i's parent is (i - 1) / 3
+    data.fullNodeDataList.resize(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        data.allNodeNames.push_back(NodeNames{ i, params.name + "_node" + std::to_string(i), 0 });
+        auto& bone = data.fullNodeDataList[i].boneData;
+        bone.Translation = { unit(rng), unit(rng), unit(rng) };
+        bone.Rotation = { unit(rng) * 0.5f, unit(rng) * 0.5f, unit(rng) * 0.5f };
+        if (i > 0)
+            data.fullNodeDataList[(i - 1) / 3].childrenIndexList.push_back(i);
+    }
+    data.rootNodes.push_back(0);
+
+    // bones are the first nodes, every mesh node links the same leading bones
+    uint32_t firstMeshNode = nodeCount - meshNodeCount;
+    uint32_t totalLinks = 0;
+    if (meshNodeCount > 0 && linkCount > 0) {
+        for (uint32_t b = 0; b < linkCount; ++b)
+            data.boneNames.push_back(data.allNodeNames[b]);
+    }
+
+    for (uint32_t n = firstMeshNode; n < nodeCount; ++n) {
+        auto& node = data.fullNodeDataList[n];
+
+        if (linkCount > 0) {
+            NodeLinks link;
+            link.MeshOffset = n;
+            for (uint32_t b = 0; b < linkCount; ++b)
+                link.BoneOffsets.push_back(b);
+            totalLinks += linkCount;
+            data.nodeLinks.push_back(link);
+        }
+
+        for (uint32_t s = 0; s < params.submeshesPerNode; ++s) {
+            SubMesh sub;
+            sub.VertexCount = verts;
+            sub.TriangleCount = verts - 2;
+            sub.MaterialIndex = (n + s) % materialCount;
+            sub.VertexPositionOffset = 1;
+            sub.VertexNormalOffset = 1;
+            sub.ColorBufferOffset = params.colors ? 1 : 0;
+            sub.TexCoord0Offset = uvSets > 0 ? 1 : 0;
+            sub.TexCoord1Offset = uvSets > 1 ? 1 : 0;
+            sub.TexCoord2Offset = uvSets > 2 ? 1 : 0;
+            sub.TexCoord3Offset = uvSets > 3 ? 1 : 0;
+            sub.FaceOffset = 1;
+
+            // rotate which links are skinned so masks differ between submeshes
+            if (skinnedCount > 0) {
+                for (uint32_t k = 0; k < skinnedCount; ++k)
+                    sub.BonesIndexMask |= 1u << ((s + k) % linkCount);
+                sub.SkinnedBonesCount = skinnedCount;
+                sub.WeightOffset = 1;
+            }
+
+            std::vector<float> positions(verts * 3), normals(verts * 3);
+            for (uint32_t v = 0; v < verts; ++v) {
+                float x = unit(rng), y = unit(rng), z = unit(rng);
+                positions[v * 3 + 0] = x * 50.f;
+                positions[v * 3 + 1] = y * 50.f;
+                positions[v * 3 + 2] = z * 50.f;
+                float len = std::sqrt(x * x + y * y + z * z) + 1e-6f;
+                normals[v * 3 + 0] = x / len;
+                normals[v * 3 + 1] = y / len;
+                normals[v * 3 + 2] = z / len;
+            }
+            node.verticesList.push_back(std::move(positions));
+            node.normalsList.push_back(std::move(normals));
+
+            if (params.colors) {
+                std::vector<float> colors(verts * 4);
+                for (float& c : colors) c = unit01(rng);
+                node.colorsList.push_back(std::move(colors));
+            }
+
+            std::vector<std::vector<float>>* uvLists[4] = { &node.uvs0List, &node.uvs1List, &node.uvs2List, &node.uvs3List };
+            for (uint32_t u = 0; u < uvSets; ++u) {
+                std::vector<float> uvs(verts * 2);
+                for (float& c : uvs) c = unit01(rng);
+                uvLists[u]->push_back(std::move(uvs));
+            }
+
+            // strip-like triangle list
+            std::vector<uint16_t> faces(sub.TriangleCount * 3);
+            for (uint32_t t = 0; t < sub.TriangleCount; ++t) {
+                faces[t * 3 + 0] = static_cast<uint16_t>(t);
+                faces[t * 3 + 1] = static_cast<uint16_t>(t + 1);
+                faces[t * 3 + 2] = static_cast<uint16_t>(t + 2);
+            }
+            node.polygonsList.push_back(std::move(faces));
+
+            // one dense row per skinned bone, normalised per vertex
+            if (skinnedCount > 0) {
+                std::vector<float> weights(skinnedCount * verts);
+                for (uint32_t v = 0; v < verts; ++v) {
+                    float sum = 0.f;
+                    for (uint32_t k = 0; k < skinnedCount; ++k) {
+                        weights[k * verts + v] = unit01(rng) + 0.01f;
+                        sum += weights[k * verts + v];
+                    }
+                    for (uint32_t k = 0; k < skinnedCount; ++k)
+                        weights[k * verts + v] /= sum;
+                }
+                node.weightsList.push_back(std::move(weights));
+            }
+
+            sub.BoundingBox = { 0.f, 0.f, 0.f, 87.f };
+            sub.BoundingBoxMaxMin = { 50.f, 50.f, 50.f, -50.f, -50.f, -50.f };
+            node.subMeshes.push_back(sub);
+        }
+    }
+
+    data.headerData.MaterialCount = materialCount;
+    data.headerData.TextureMapsCount = static_cast<uint32_t>(data.textureNames.size());
+    data.headerData.BoneCount = static_cast<uint32_t>(data.boneNames.size());
+    data.headerData.LinkNodeCount = totalLinks;
+    data.headerData.TotalNodeCount = nodeCount;
+    return data;
+}
+
+uint64_t CountVertices(const MKDXData& data)
+{
+    uint64_t total = 0;
+    for (const auto& node : data.fullNodeDataList)
+        for (const auto& sub : node.subMeshes)
+            total += sub.VertexCount;
+    return total;
+}
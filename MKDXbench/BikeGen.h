@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "CoolStructs.h"
+
+// knobs for a synthetic BIKE model, counts are per mesh node / per submesh
+struct SynthModelParams {
+    std::string name = "synth";
+    uint32_t nodeCount = 64;            // total nodes incl bones, tree with 3 children per node
+    uint32_t meshNodeCount = 16;        // last n nodes get submeshes
+    uint32_t submeshesPerNode = 2;
+    uint32_t vertsPerSubmesh = 1000;    // max 65535, faces are uint16
+    uint32_t uvSets = 1;                // 0-4
+    bool colors = true;
+    uint32_t linksPerMeshNode = 8;      // bones linked to each mesh node, max 32 (mask is 32 bits)
+    uint32_t skinnedBonesPerSubmesh = 4; // bits set in BonesIndexMask, max 6 like the game
+    uint32_t materialCount = 8;
+    uint32_t seed = 1234;
+};
+
+// same shape the import path hands to SaveMKDXFile (node indices as offsets, buffer offsets of 1 = present)
+MKDXData GenerateSynthModel(const SynthModelParams& params);
+
+uint64_t CountVertices(const MKDXData& data);
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <random>
+#include <sstream>
+#include <cmath>
+
+#include "DaeGen.h"
+
+static std::string MeshName(const SynthDaeParams& params, uint32_t i)
+{
+    return params.name + "_mesh" + std::to_string(i);
+}
+
+static const char* identityMatrix = "1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1";
+
+static void WriteJointNode(std::ostringstream& out, const std::vector<std::vector<uint32_t>>& children, uint32_t joint, float offset)
+{
+    std::string name = "joint" + std::to_string(joint);
+    out << "<node id=\"" << name << "\" name=\"" << name << "\" sid=\"" << name << "\" type=\"JOINT\">\n"
+        << "<matrix sid=\"transform\">1 0 0 0 0 1 0 " << offset << " 0 0 1 0 0 0 0 1</matrix>\n";
+    for (uint32_t child : children[joint])
+        WriteJointNode(out, children, child, offset);
+    out << "</node>\n";
+}
+
+static void WriteBindMaterial(std::ostringstream& out)
+{
+    out << "<bind_material><technique_common><instance_material symbol=\"defaultMaterial\" target=\"#material_0\"/></technique_common></bind_material>\n";
+}
+
+std::vector<std::string> SynthDaeMeshNames(const SynthDaeParams& params)
+{
+    std::vector<std::string> names;
+    for (uint32_t i = 0; i < params.meshCount; ++i)
+        names.push_back(MeshName(params, i));
+    return names;
+}
+
+std::string SynthDaeMatInfo(const SynthDaeParams& params)
+{
+    uint32_t tris = std::max(1u, params.trianglesPerMesh);
+    uint32_t mats = std::min(std::max(1u, params.materialsPerMesh), tris);
+
+    std::ostringstream out;
+    for (uint32_t i = 0; i < params.meshCount; ++i) {
+        out << "mesh\n";
+        for (uint32_t m = 0; m < mats; ++m) {
+            out << m << ":";
+            for (uint32_t t = tris * m / mats; t < tris * (m + 1) / mats; ++t)
+                out << t << "," << t + 1 << "," << t + 2 << ",";
+            out << "\n";
+        }
+        out << "endmesh\n";
+    }
+    return out.str();
+}
+
+std::string GenerateSynthDae(const SynthDaeParams& params)
+{
+    std::mt19937 rng(params.seed);
+    std::uniform_real_distribution<float> unit(-1.f, 1.f);
+    std::uniform_real_distribution<float> unit01(0.f, 1.f);
+
+    uint32_t tris = std::max(1u, params.trianglesPerMesh);
+    uint32_t verts = tris + 2;
+    uint32_t jointCount = std::max(1u, params.jointCount);
+    uint32_t branching = std::max(1u, params.jointBranching);
+    uint32_t influences = std::min(std::max(1u, params.influencesPerVertex), jointCount);
+
+    std::ostringstream out;
+    out << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+        << "<COLLADA xmlns=\"http://www.collada.org/2005/11/COLLADASchema\" version=\"1.4.1\">\n"
+        << "<asset>\n<contributor><author>Assimp</author><authoring_tool>Assimp Exporter</authoring_tool></contributor>\n"
+        << "<unit name=\"meter\" meter=\"1\"/>\n<up_axis>Y_UP</up_axis>\n</asset>\n";
+
+    // geometry, one polylist per mesh like the assimp exporter writes
+    out << "<library_geometries>\n";
+    for (uint32_t i = 0; i < params.meshCount; ++i) {
+        std::string name = MeshName(params, i);
+        std::string id = name + "_1";
+
+        std::vector<float> positions(verts * 3), normals(verts * 3);
+        for (uint32_t v = 0; v < verts; ++v) {
+            // uv seams, same position + normal on a new vertex so the merge pass has work to do
+            if (params.seamEvery > 0 && v > 0 && v % params.seamEvery == 0) {
+                std::copy(positions.begin() + (v - 1) * 3, positions.begin() + v * 3, positions.begin() + v * 3);
+                std::copy(normals.begin() + (v - 1) * 3, normals.begin() + v * 3, normals.begin() + v * 3);
+                continue;
+            }
+            float x = unit(rng), y = unit(rng), z = unit(rng);
+            float len = std::sqrt(x * x + y * y + z * z) + 1e-6f;
+            for (int k = 0; k < 3; ++k) {
+                float c = k == 0 ? x : (k == 1 ? y : z);
+                positions[v * 3 + k] = c * 50.f;
+                normals[v * 3 + k] = c / len;
+            }
+        }
+
+        out << "<geometry id=\"" << id << "\" name=\"" << name << "\">\n<mesh>\n";
+
+        out << "<source id=\"" << id << "-positions\" name=\"" << id << "-positions\">\n"
+            << "<float_array id=\"" << id << "-positions-array\" count=\"" << verts * 3 << "\">";
+        for (uint32_t f = 0; f < verts * 3; ++f) out << (f ? " " : "") << positions[f];
+        out << "</float_array>\n<technique_common><accessor count=\"" << verts << "\" offset=\"0\" source=\"#" << id << "-positions-array\" stride=\"3\">"
+            << "<param name=\"X\" type=\"float\"/><param name=\"Y\" type=\"float\"/><param name=\"Z\" type=\"float\"/></accessor></technique_common>\n</source>\n";
+
+        out << "<source id=\"" << id << "-normals\" name=\"" << id << "-normals\">\n"
+            << "<float_array id=\"" << id << "-normals-array\" count=\"" << verts * 3 << "\">";
+        for (uint32_t f = 0; f < verts * 3; ++f) out << (f ? " " : "") << normals[f];
+        out << "</float_array>\n<technique_common><accessor count=\"" << verts << "\" offset=\"0\" source=\"#" << id << "-normals-array\" stride=\"3\">"
+            << "<param name=\"X\" type=\"float\"/><param name=\"Y\" type=\"float\"/><param name=\"Z\" type=\"float\"/></accessor></technique_common>\n</source>\n";
+
+        out << "<source id=\"" << id << "-tex0\" name=\"" << id << "-tex0\">\n"
+            << "<float_array id=\"" << id << "-tex0-array\" count=\"" << verts * 2 << "\">";
+        for (uint32_t f = 0; f < verts * 2; ++f) out << (f ? " " : "") << unit01(rng);
+        out << "</float_array>\n<technique_common><accessor count=\"" << verts << "\" offset=\"0\" source=\"#" << id << "-tex0-array\" stride=\"2\">"
+            << "<param name=\"S\" type=\"float\"/><param name=\"T\" type=\"float\"/></accessor></technique_common>\n</source>\n";
+
+        out << "<vertices id=\"" << id << "-vertices\"><input semantic=\"POSITION\" source=\"#" << id << "-positions\"/></vertices>\n";
+
+        const char* block = params.polylists ? "polylist" : "triangles";
+        out << "<" << block << " count=\"" << tris << "\" material=\"defaultMaterial\">\n"
+            << "<input offset=\"0\" semantic=\"VERTEX\" source=\"#" << id << "-vertices\"/>\n"
+            << "<input offset=\"0\" semantic=\"NORMAL\" source=\"#" << id << "-normals\"/>\n"
+            << "<input offset=\"0\" semantic=\"TEXCOORD\" source=\"#" << id << "-tex0\" set=\"0\"/>\n";
+        if (params.polylists) {
+            out << "<vcount>";
+            for (uint32_t t = 0; t < tris; ++t) out << (t ? " 3" : "3");
+            out << "</vcount>\n";
+        }
+        out << "<p>";
+        for (uint32_t t = 0; t < tris; ++t) out << (t ? " " : "") << t << " " << t + 1 << " " << t + 2;
+        out << "</p>\n</" << block << ">\n</mesh>\n</geometry>\n";
+    }
+    out << "</library_geometries>\n";
+
+    // one skin per mesh, every controller lists every joint
+    out << "<library_controllers>\n";
+    for (uint32_t i = 0; i < params.meshCount; ++i) {
+        std::string id = MeshName(params, i) + "_1";
+        std::string skinId = id + "-skin";
+
+        out << "<controller id=\"" << skinId << "\">\n<skin source=\"#" << id << "\">\n"
+            << "<bind_shape_matrix>" << identityMatrix << "</bind_shape_matrix>\n";
+
+        out << "<source id=\"" << skinId << "-joints\">\n<Name_array id=\"" << skinId << "-joints-array\" count=\"" << jointCount << "\">";
+        for (uint32_t j = 0; j < jointCount; ++j) out << (j ? " " : "") << "joint" << j;
+        out << "</Name_array>\n<technique_common><accessor source=\"#" << skinId << "-joints-array\" count=\"" << jointCount << "\" stride=\"1\">"
+            << "<param name=\"JOINT\" type=\"name\"/></accessor></technique_common>\n</source>\n";
+
+        out << "<source id=\"" << skinId << "-bind_poses\">\n<float_array id=\"" << skinId << "-bind_poses-array\" count=\"" << jointCount * 16 << "\">";
+        for (uint32_t j = 0; j < jointCount; ++j) out << (j ? " " : "") << identityMatrix;
+        out << "</float_array>\n<technique_common><accessor source=\"#" << skinId << "-bind_poses-array\" count=\"" << jointCount << "\" stride=\"16\">"
+            << "<param name=\"TRANSFORM\" type=\"float4x4\"/></accessor></technique_common>\n</source>\n";
+
+        // neighbouring vertices share joints so the pre-import grouping ends up with a handful of sets
+        std::vector<float> weights(verts * influences);
+        for (uint32_t v = 0; v < verts; ++v) {
+            float sum = 0.f;
+            for (uint32_t k = 0; k < influences; ++k) sum += (weights[v * influences + k] = unit01(rng) + 0.01f);
+            for (uint32_t k = 0; k < influences; ++k) weights[v * influences + k] /= sum;
+        }
+
+        out << "<source id=\"" << skinId << "-weights\">\n<float_array id=\"" << skinId << "-weights-array\" count=\"" << weights.size() << "\">";
+        for (size_t w = 0; w < weights.size(); ++w) out << (w ? " " : "") << weights[w];
+        out << "</float_array>\n<technique_common><accessor source=\"#" << skinId << "-weights-array\" count=\"" << weights.size() << "\" stride=\"1\">"
+            << "<param name=\"WEIGHT\" type=\"float\"/></accessor></technique_common>\n</source>\n";
+
+        out << "<joints><input semantic=\"JOINT\" source=\"#" << skinId << "-joints\"/><input semantic=\"INV_BIND_MATRIX\" source=\"#" << skinId << "-bind_poses\"/></joints>\n"
+            << "<vertex_weights count=\"" << verts << "\">\n"
+            << "<input semantic=\"JOINT\" source=\"#" << skinId << "-joints\" offset=\"0\"/>\n"
+            << "<input semantic=\"WEIGHT\" source=\"#" << skinId << "-weights\" offset=\"1\"/>\n<vcount>";
+        for (uint32_t v = 0; v < verts; ++v) out << (v ? " " : "") << influences;
+        out << "</vcount>\n<v>";
+        for (uint32_t v = 0; v < verts; ++v)
+            for (uint32_t k = 0; k < influences; ++k)
+                out << (v || k ? " " : "") << (v / 64 + k) % jointCount << " " << v * influences + k;
+        out << "</v>\n</vertex_weights>\n</skin>\n</controller>\n";
+    }
+    out << "</library_controllers>\n";
+
+    // joint tree under the armature, joint j's parent is (j - 1) / branching
+    std::vector<std::vector<uint32_t>> children(jointCount);
+    for (uint32_t j = 1; j < jointCount; ++j)
+        children[(j - 1) / branching].push_back(j);
+
+    out << "<library_visual_scenes>\n<visual_scene id=\"Scene\" name=\"Scene\">\n"
+        << "<node id=\"Armature\" name=\"Armature\" type=\"NODE\">\n<matrix sid=\"transform\">" << identityMatrix << "</matrix>\n";
+    WriteJointNode(out, children, 0, 0.1f);
+    out << "</node>\n";
+
+    for (uint32_t i = 0; i < params.meshCount; ++i) {
+        std::string name = MeshName(params, i);
+        std::string id = name + "_1";
+        out << "<node id=\"" << name << "\" name=\"" << name << "\" type=\"NODE\">\n<matrix sid=\"transform\">" << identityMatrix << "</matrix>\n"
+            << "<instance_controller url=\"#" << id << "-skin\">\n<skeleton>#joint0</skeleton>\n";
+        WriteBindMaterial(out);
+        out << "</instance_controller>\n";
+
+        if (params.splitMeshes && i % 2 == 1) {
+            out << "<node id=\"" << name << ".001\" name=\"" << name << ".001\" type=\"NODE\">\n<matrix sid=\"transform\">" << identityMatrix << "</matrix>\n"
+                << "<instance_geometry url=\"#" << id << "\">\n";
+            WriteBindMaterial(out);
+            out << "</instance_geometry>\n</node>\n";
+        }
+        out << "</node>\n";
+    }
+
+    out << "</visual_scene>\n</library_visual_scenes>\n"
+        << "<scene><instance_visual_scene url=\"#Scene\"/></scene>\n</COLLADA>\n";
+    return out.str();
+}
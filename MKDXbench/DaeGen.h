@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// knobs for a synthetic COLLADA file shaped like what assimp/blender hand the patcher
+struct SynthDaeParams {
+    std::string name = "synth";
+    uint32_t meshCount = 4;
+    uint32_t trianglesPerMesh = 500;    // strip-like, so verts = triangles + 2
+    uint32_t materialsPerMesh = 2;      // triangle ranges written to the allmatinfo file
+    uint32_t jointCount = 16;
+    uint32_t jointBranching = 3;        // children per joint, 1 = one long chain (deep nesting)
+    uint32_t influencesPerVertex = 4;
+    uint32_t seamEvery = 8;             // every nth vertex repeats the previous position + normal, 0 = never
+    bool splitMeshes = true;            // every other mesh gets a blender style ".001" child to absorb
+    bool polylists = true;              // false = <triangles>, what the export passes see after PatchDaeFile
+    uint32_t seed = 1234;
+};
+
+// full document text, mesh nodes sit next to the Armature node like a blender export
+std::string GenerateSynthDae(const SynthDaeParams& params);
+
+// names NodeToSubmesh_C gets handed, same as the mesh list main builds from the preset
+std::vector<std::string> SynthDaeMeshNames(const SynthDaeParams& params);
+
+// allmatinfo.txt contents for PatchDaeFile_C, same format SaveFuncs serializes
+std::string SynthDaeMatInfo(const SynthDaeParams& params);
@@ -0,0 +1,217 @@
+#include <tinyxml2.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cmath>
+#include <cstdio>
+#include <io.h>
+#include <fcntl.h>
+#include <windows.h>
+
+#include "Bench.h"
+#include "DaeGen.h"
+
+// same signatures the tool calls through in CoolStuff.cpp / SaveFuncs.cpp
+typedef void(__cdecl* PatchDaeFileFunc)(const char*, const char*);
+typedef void(__cdecl* NodeToSubmeshFunc)(const char*, const char** meshList, int meshCount);
+typedef void(__cdecl* PatchDaePreImportFunc)(const char*, const char*);
+typedef void(__cdecl* PatchDaePreAllFunc)(const char*);
+
+// the passes print per node with both printf and cout, point the console fd at NUL while timing
+class QuietConsole {
+public:
+    QuietConsole()
+    {
+        fflush(stdout);
+        saved = _dup(_fileno(stdout));
+        int nul = _open("NUL", _O_WRONLY);
+        if (nul >= 0) {
+            _dup2(nul, _fileno(stdout));
+            _close(nul);
+        }
+    }
+    ~QuietConsole()
+    {
+        fflush(stdout);
+        if (saved >= 0) {
+            _dup2(saved, _fileno(stdout));
+            _close(saved);
+        }
+    }
+
+private:
+    QuietStdout quietCout;
+    int saved = -1;
+};
+
+struct ScalingAxis {
+    const char* name;
+    const char* unit;
+    std::vector<uint32_t> sizes;
+    std::vector<SynthDaeParams> steps;
+};
+
+// each axis doubles one thing and keeps the rest at the base size, so the exponent column is per input dimension
+static std::vector<ScalingAxis> PatchScalingAxes()
+{
+    SynthDaeParams base;
+    base.meshCount = 4;
+    base.trianglesPerMesh = 500;
+    base.jointCount = 32;
+
+    std::vector<ScalingAxis> axes;
+
+    ScalingAxis triangles{ "triangles", "tris/mesh" };
+    for (uint32_t n : { 500u, 1000u, 2000u, 4000u }) {
+        SynthDaeParams p = base;
+        p.trianglesPerMesh = n;
+        triangles.sizes.push_back(n);
+        triangles.steps.push_back(p);
+    }
+    axes.push_back(triangles);
+
+    ScalingAxis meshes{ "meshes", "meshes" };
+    for (uint32_t n : { 4u, 8u, 16u, 32u }) {
+        SynthDaeParams p = base;
+        p.meshCount = n;
+        meshes.sizes.push_back(n);
+        meshes.steps.push_back(p);
+    }
+    axes.push_back(meshes);
+
+    ScalingAxis joints{ "joints", "joints" };
+    for (uint32_t n : { 32u, 64u, 128u, 256u }) {
+        SynthDaeParams p = base;
+        p.jointCount = n;
+        p.jointBranching = 4;
+        joints.sizes.push_back(n);
+        joints.steps.push_back(p);
+    }
+    axes.push_back(joints);
+
+    // one long joint chain, tinyxml2 refuses documents nested much deeper than 500
+    ScalingAxis nesting{ "nesting", "depth" };
+    for (uint32_t n : { 32u, 64u, 128u, 256u }) {
+        SynthDaeParams p = base;
+        p.jointCount = n;
+        p.jointBranching = 1;
+        nesting.sizes.push_back(n);
+        nesting.steps.push_back(p);
+    }
+    axes.push_back(nesting);
+
+    for (auto& axis : axes)
+        for (size_t i = 0; i < axis.steps.size(); ++i)
+            axis.steps[i].name = std::string(axis.name) + std::to_string(i);
+    return axes;
+}
+
+static void WriteTextFile(const std::string& path, const std::string& text)
+{
+    std::ofstream out(path, std::ios::binary);
+    out.write(text.data(), text.size());
+}
+
+struct PatchPass {
+    const char* label;
+    std::function<void(const std::string& path)> run;
+};
+
+void RunPatchBench(const BenchOptions& options)
+{
+    std::cout << "\n\033[34m--- tinyxml2patcher passes ---\033[37m (median of " << options.iterations << ")\n";
+
+    HMODULE dll = LoadLibraryA("tinyxml2patcher.dll");
+    if (!dll) {
+        std::cerr << "Failed to load tinyxml2patcher.dll, skipping patch benches\n";
+        return;
+    }
+
+    auto patchDaeFile = (PatchDaeFileFunc)GetProcAddress(dll, "PatchDaeFile_C");
+    auto nodeToSubmesh = (NodeToSubmeshFunc)GetProcAddress(dll, "NodeToSubmesh_C");
+    auto preImport = (PatchDaePreImportFunc)GetProcAddress(dll, "PatchDaePreImport_C");
+    auto preAll = (PatchDaePreAllFunc)GetProcAddress(dll, "PatchDaePreAll_C");
+    if (!patchDaeFile || !nodeToSubmesh || !preImport || !preAll) {
+        std::cerr << "tinyxml2patcher.dll is missing an export, skipping patch benches\n";
+        FreeLibrary(dll);
+        return;
+    }
+
+    std::string workPath = options.tempDir + "patch_work.dae";
+    std::string matInfoPath = options.tempDir + "patch_allmatinfo.txt";
+    std::string groupsPath = options.tempDir + "patch_final_groups.t";
+    std::vector<std::string> meshNames;
+
+    std::vector<PatchPass> passes = {
+        // baseline, what any pass pays just to parse and write the file back
+        { "load+save", [](const std::string& path) {
+            tinyxml2::XMLDocument doc;
+            doc.LoadFile(path.c_str());
+            doc.SaveFile(path.c_str());
+        } },
+        { "PreAll", [&](const std::string& path) { preAll(path.c_str()); } },
+        { "PreImport", [&](const std::string& path) { preImport(path.c_str(), groupsPath.c_str()); } },
+        { "NodeToSubmesh", [&](const std::string& path) {
+            std::vector<const char*> names;
+            for (const auto& n : meshNames) names.push_back(n.c_str());
+            nodeToSubmesh(path.c_str(), names.data(), static_cast<int>(names.size()));
+        } },
+        { "PatchDaeFile", [&](const std::string& path) { patchDaeFile(path.c_str(), matInfoPath.c_str()); } },
+    };
+
+    for (const auto& axis : PatchScalingAxes()) {
+        if (!options.only.empty() && options.only != axis.name) continue;
+
+        std::cout << std::dec << "\n[" << axis.name << "] " << std::left << std::setw(14) << axis.unit << std::right;
+        for (uint32_t size : axis.sizes) std::cout << std::setw(10) << size;
+        std::cout << std::setw(10) << "exp" << "\n";
+
+        std::vector<std::vector<double>> medians(passes.size());
+        std::vector<double> megabytes;
+
+        for (const auto& params : axis.steps) {
+            std::string polyText = GenerateSynthDae(params);
+            megabytes.push_back(polyText.size() / (1024.0 * 1024.0));
+
+            WriteTextFile(matInfoPath, SynthDaeMatInfo(params));
+            meshNames = SynthDaeMeshNames(params);
+
+            for (size_t p = 0; p < passes.size(); ++p) {
+                std::vector<double> times;
+                for (int i = 0; i < options.iterations; ++i) {
+                    // every pass patches the file in place, so each run starts from a fresh copy
+                    WriteTextFile(workPath, polyText);
+                    QuietConsole quiet;
+                    times.push_back(TimeMs([&] { passes[p].run(workPath); }));
+                }
+                medians[p].push_back(Median(times));
+            }
+        }
+
+        std::cout << "  " << std::left << std::setw(20) << "file MB" << std::right << std::fixed << std::setprecision(2);
+        for (double mb : megabytes) std::cout << std::setw(10) << mb;
+        std::cout << "\n";
+
+        // exponent of time vs size over the whole axis, ~1 linear, ~2 quadratic
+        double sizeRatio = static_cast<double>(axis.sizes.back()) / axis.sizes.front();
+        for (size_t p = 0; p < passes.size(); ++p) {
+            std::cout << "  " << std::left << std::setw(20) << passes[p].label << std::right;
+            for (double ms : medians[p]) std::cout << std::setw(10) << std::setprecision(2) << ms;
+
+            double first = medians[p].front(), last = medians[p].back();
+            double exponent = first > 0 && last > 0 ? std::log(last / first) / std::log(sizeRatio) : 0;
+            std::cout << std::setw(10) << std::setprecision(2) << exponent;
+            // small timings are mostly noise, only call it out once the pass costs something
+            if (exponent > 1.5 && last > 1.0)
+                std::cout << " \033[31msuperlinear\033[37m";
+            std::cout << "\n";
+        }
+    }
+
+    std::remove(workPath.c_str());
+    std::remove(matInfoPath.c_str());
+    FreeLibrary(dll);
+}
@@ -0,0 +1,244 @@
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <thread>
+
+#include "AnimBounds.h"
+#include "AnimEval.h"
+#include "Skinning.h"
+#include "Profiler.h"
+
+// running union of every pose seen, one per clip thread then merged
+// submesh bounds are in model space and node bounds in the node's parent space, the same as the importer writes them
+// (submeshes through every ancestor's transform, nodes through collectWorldVerts from the node itself)
+struct BoundsAccum {
+    std::vector<float> subMin, subMax;    // xyz per submesh
+    std::vector<float> subRadiusSq;       // per submesh, from its centre
+    std::vector<float> nodeMin, nodeMax;  // xyz per node
+    std::vector<float> nodeRadiusSq;      // per node, from its centre
+
+    BoundsAccum(size_t subCount, size_t nodeCount)
+        : subMin(subCount * 3, FLT_MAX), subMax(subCount * 3, -FLT_MAX), subRadiusSq(subCount, 0.f),
+          nodeMin(nodeCount * 3, FLT_MAX), nodeMax(nodeCount * 3, -FLT_MAX), nodeRadiusSq(nodeCount, 0.f) {}
+
+    void Merge(const BoundsAccum& other) {
+        for (size_t i = 0; i < subMin.size(); ++i) {
+            subMin[i] = std::min(subMin[i], other.subMin[i]);
+            subMax[i] = std::max(subMax[i], other.subMax[i]);
+        }
+        for (size_t i = 0; i < nodeMin.size(); ++i) {
+            nodeMin[i] = std::min(nodeMin[i], other.nodeMin[i]);
+            nodeMax[i] = std::max(nodeMax[i], other.nodeMax[i]);
+        }
+        for (size_t i = 0; i < subRadiusSq.size(); ++i) subRadiusSq[i] = std::max(subRadiusSq[i], other.subRadiusSq[i]);
+        for (size_t i = 0; i < nodeRadiusSq.size(); ++i) nodeRadiusSq[i] = std::max(nodeRadiusSq[i], other.nodeRadiusSq[i]);
+    }
+};
+
+// centres are the .bin's own sphere centres (bind pose centroid where a sphere was never set), each in its bounds' space
+// ancestors[i] is every node whose bounds submesh i counts towards (its own node first)
+struct BoundsLayout {
+    std::vector<aiVector3D> subCentres;
+    std::vector<aiVector3D> nodeCentres;
+    std::vector<std::vector<uint32_t>> ancestors;
+    std::vector<int32_t> parents;
+};
+
+// per node, model space -> the node's parent space for one pose, roots stay in model space
+static void ParentSpaceMatrices(const BoundsLayout& layout, const std::vector<aiMatrix4x4>& world, std::vector<aiMatrix4x4>& toParent)
+{
+    toParent.resize(layout.parents.size());
+    for (size_t n = 0; n < layout.parents.size(); ++n) {
+        toParent[n] = aiMatrix4x4();
+        if (layout.parents[n] >= 0) toParent[n] = aiMatrix4x4(world[layout.parents[n]]).Inverse();
+    }
+}
+
+static void AccumulatePose(const std::vector<SkinnedSubMesh>& skinned, const BoundsLayout& layout, const std::vector<aiMatrix4x4>& toParent,
+    BoundsAccum& acc)
+{
+    for (size_t i = 0; i < skinned.size(); ++i) {
+        const std::vector<float>& positions = skinned[i].positions;
+        float* lo = &acc.subMin[i * 3];
+        float* hi = &acc.subMax[i * 3];
+        const aiVector3D& centre = layout.subCentres[i];
+        float radiusSq = acc.subRadiusSq[i];
+
+        for (size_t v = 0; v < positions.size(); v += 3) {
+            float x = positions[v], y = positions[v + 1], z = positions[v + 2];
+            lo[0] = std::min(lo[0], x); lo[1] = std::min(lo[1], y); lo[2] = std::min(lo[2], z);
+            hi[0] = std::max(hi[0], x); hi[1] = std::max(hi[1], y); hi[2] = std::max(hi[2], z);
+            float dx = x - centre.x, dy = y - centre.y, dz = z - centre.z;
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy + dz * dz);
+        }
+        acc.subRadiusSq[i] = radiusSq;
+
+        // node bounds are in another space so they need the vertices again, trees are shallow so this stays cheap
+        for (uint32_t node : layout.ancestors[i]) {
+            const aiMatrix4x4& m = toParent[node];
+            const aiVector3D& nodeCentre = layout.nodeCentres[node];
+            float* nodeLo = &acc.nodeMin[node * 3];
+            float* nodeHi = &acc.nodeMax[node * 3];
+            float nodeRadiusSq = acc.nodeRadiusSq[node];
+            for (size_t v = 0; v < positions.size(); v += 3) {
+                float px = positions[v], py = positions[v + 1], pz = positions[v + 2];
+                float x = m.a1 * px + m.a2 * py + m.a3 * pz + m.a4;
+                float y = m.b1 * px + m.b2 * py + m.b3 * pz + m.b4;
+                float z = m.c1 * px + m.c2 * py + m.c3 * pz + m.c4;
+                nodeLo[0] = std::min(nodeLo[0], x); nodeLo[1] = std::min(nodeLo[1], y); nodeLo[2] = std::min(nodeLo[2], z);
+                nodeHi[0] = std::max(nodeHi[0], x); nodeHi[1] = std::max(nodeHi[1], y); nodeHi[2] = std::max(nodeHi[2], z);
+                float dx = x - nodeCentre.x, dy = y - nodeCentre.y, dz = z - nodeCentre.z;
+                nodeRadiusSq = std::max(nodeRadiusSq, dx * dx + dy * dy + dz * dz);
+            }
+            acc.nodeRadiusSq[node] = nodeRadiusSq;
+        }
+    }
+}
+
+// sphere becomes centre + the bigger of the old and sampled radius, box the union of the old one (unless it was never
+// set, all zeros) and the sampled min/max, returns whether either got bigger
+static bool GrowBounds(std::vector<float>& sphere, std::vector<float>& maxMin, const aiVector3D& centre, float sampledRadius,
+    const float* sampledMin, const float* sampledMax, AnimBoundsReport& report)
+{
+    float oldRadius = sphere.size() >= 4 ? sphere[3] : 0.f;
+    float radius = std::max(oldRadius, sampledRadius);
+    report.maxRadiusGrowth = std::max(report.maxRadiusGrowth, radius - oldRadius);
+    bool grown = radius - oldRadius > 1e-4f;
+    sphere = { centre.x, centre.y, centre.z, radius };
+
+    bool boxSet = false;
+    for (float value : maxMin) boxSet |= value != 0.f;
+    maxMin.resize(6, 0.f);
+    for (int a = 0; a < 3; ++a) {
+        float hi = boxSet ? std::max(maxMin[a], sampledMax[a]) : sampledMax[a];
+        float lo = boxSet ? std::min(maxMin[3 + a], sampledMin[a]) : sampledMin[a];
+        grown |= boxSet && (hi > maxMin[a] + 1e-4f || lo < maxMin[3 + a] - 1e-4f);
+        maxMin[a] = hi;
+        maxMin[3 + a] = lo;
+    }
+    return grown;
+}
+
+void UpdateAnimatedBounds(MKDXData& model, const std::vector<MotData>& clips, float samplesPerSecond, AnimBoundsReport& report)
+{
+    PROFILE_SCOPE("UpdateAnimatedBounds");
+    size_t nodeCount = model.fullNodeDataList.size();
+    std::vector<aiMatrix4x4> bindWorld = ModelBindWorldMatrices(model);
+    MotPoseBinding restBinding = BindMotToModel(MotData(), model);
+
+    std::vector<SkinnedSubMesh> bindSkin;
+    SkinModel(model, bindWorld, bindWorld, bindSkin);
+    size_t subCount = bindSkin.size();
+
+    // spheres only ever grow around the centre the .bin already has, the bind pose centroid (like the importer) stands in
+    // for ones that were never set, per submesh and per node over everything at or below it
+    ProfileScope layoutStage("bounds centres");
+    BoundsLayout layout;
+    layout.subCentres.resize(subCount);
+    layout.nodeCentres.assign(nodeCount, aiVector3D(0.f, 0.f, 0.f));
+    layout.ancestors.resize(subCount);
+    layout.parents = restBinding.parents;
+    std::vector<size_t> nodeVertexCount(nodeCount, 0);
+    for (size_t i = 0; i < subCount; ++i) {
+        const std::vector<float>& positions = bindSkin[i].positions;
+        size_t vertexCount = positions.size() / 3;
+        aiVector3D sum(0.f, 0.f, 0.f);
+        for (size_t v = 0; v < positions.size(); v += 3)
+            sum += aiVector3D(positions[v], positions[v + 1], positions[v + 2]);
+        layout.subCentres[i] = vertexCount ? sum / static_cast<float>(vertexCount) : sum;
+
+        for (int32_t node = static_cast<int32_t>(bindSkin[i].node); node >= 0; node = restBinding.parents[node]) {
+            layout.ancestors[i].push_back(static_cast<uint32_t>(node));
+            layout.nodeCentres[node] += sum;
+            nodeVertexCount[node] += vertexCount;
+        }
+    }
+    std::vector<aiMatrix4x4> toParent;
+    ParentSpaceMatrices(layout, bindWorld, toParent);
+    for (size_t n = 0; n < nodeCount; ++n)
+        if (nodeVertexCount[n]) layout.nodeCentres[n] = toParent[n] * (layout.nodeCentres[n] / static_cast<float>(nodeVertexCount[n]));
+    auto existingCentre = [](const std::vector<float>& sphere, aiVector3D& centre) {
+        if (sphere.size() >= 4 && sphere[3] > 0.f) centre = aiVector3D(sphere[0], sphere[1], sphere[2]);
+    };
+    for (size_t i = 0; i < subCount; ++i)
+        existingCentre(model.fullNodeDataList[bindSkin[i].node].subMeshes[bindSkin[i].subMesh].BoundingBox, layout.subCentres[i]);
+    for (size_t n = 0; n < nodeCount; ++n)
+        if (nodeVertexCount[n]) existingCentre(model.fullNodeDataList[n].boneData.BoundingBox, layout.nodeCentres[n]);
+    layoutStage.End();
+
+    BoundsAccum total(subCount, nodeCount);
+    AccumulatePose(bindSkin, layout, toParent, total);
+    report.samples = 1;
+
+    // a thread per clip, skinning gets the cores left over
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    unsigned int clipThreads = static_cast<unsigned int>(std::min<size_t>(cores, clips.size()));
+    unsigned int skinThreads = std::max(1u, cores / std::max(1u, clipThreads));
+    float frameStep = 60.f / std::max(samplesPerSecond, 0.001f); // frames are 1/60s
+
+    std::vector<BoundsAccum> clipAccums(clips.size(), BoundsAccum(subCount, nodeCount));
+    std::vector<size_t> clipSamples(clips.size(), 0);
+    std::atomic<size_t> nextClip(0);
+    auto worker = [&](unsigned int threadIndex) {
+        if (threadIndex > 0) SetTraceThreadName("bounds " + std::to_string(threadIndex));
+        std::vector<aiMatrix4x4> local, world, poseToParent;
+        std::vector<SkinnedSubMesh> skinned;
+        for (size_t c = nextClip++; c < clips.size(); c = nextClip++) {
+            PROFILE_SCOPE("sample clip");
+            const MotData& clip = clips[c];
+            MotEvaluator eval(clip);
+            MotPoseBinding binding = BindMotToModel(clip, model);
+
+            float first = clip.headerData.FrameOne;
+            float last = std::max(clip.headerData.FrameLast, first);
+            for (float frame = first; ; frame = std::min(frame + frameStep, last)) {
+                eval.EvaluateLocal(frame, local);
+                ComposeWorldMatrices(binding, local, world);
+                SkinModel(model, bindWorld, world, skinned, skinThreads);
+                // the node's bounds ride on its parent, so they're measured against where the parent is in this pose
+                ParentSpaceMatrices(layout, world, poseToParent);
+                AccumulatePose(skinned, layout, poseToParent, clipAccums[c]);
+                clipSamples[c]++;
+                if (frame >= last) break;
+            }
+        }
+    };
+
+    {
+        PROFILE_SCOPE("sample clips");
+        std::vector<std::thread> threads;
+        int profileStage = CurrentProfileStage();
+        for (unsigned int t = 1; t < clipThreads; ++t) {
+            threads.emplace_back([&worker, t, profileStage]() {
+                ProfileThreadParent profileParent(profileStage);
+                worker(t);
+            });
+        }
+        worker(0);
+        for (auto& thread : threads) thread.join();
+    }
+
+    for (size_t c = 0; c < clips.size(); ++c) {
+        total.Merge(clipAccums[c]);
+        report.samples += clipSamples[c];
+    }
+    report.clips = clips.size();
+
+    // write it back the way the importer lays it out, max xyz then min xyz and centre + radius, grown to take in what
+    // was sampled but never smaller than what the .bin had
+    PROFILE_SCOPE("write bounds");
+    for (size_t i = 0; i < subCount; ++i) {
+        SubMesh& sub = model.fullNodeDataList[bindSkin[i].node].subMeshes[bindSkin[i].subMesh];
+        if (bindSkin[i].positions.empty()) continue;
+        if (GrowBounds(sub.BoundingBox, sub.BoundingBoxMaxMin, layout.subCentres[i], std::sqrt(total.subRadiusSq[i]), &total.subMin[i * 3], &total.subMax[i * 3], report))
+            report.subMeshesGrown++;
+    }
+
+    for (size_t n = 0; n < nodeCount; ++n) {
+        if (!nodeVertexCount[n]) continue;
+        BoneData& bone = model.fullNodeDataList[n].boneData;
+        if (GrowBounds(bone.BoundingBox, bone.BoundingBoxMaxMin, layout.nodeCentres[n], std::sqrt(total.nodeRadiusSq[n]), &total.nodeMin[n * 3], &total.nodeMax[n * 3], report))
+            report.nodesGrown++;
+    }
+}
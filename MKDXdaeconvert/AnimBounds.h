@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "CoolStructs.h"
+
+struct AnimBoundsReport {
+    size_t clips = 0;
+    size_t samples = 0;            // poses skinned, bind pose included
+    size_t subMeshesGrown = 0;
+    size_t nodesGrown = 0;
+    float maxRadiusGrowth = 0.f;   // largest radius increase over what the .bin had, never negative
+};
+
+// skins the model at the bind pose and at samplesPerSecond through every clip, then writes the union of all of them
+// into SubMesh::BoundingBox/BoundingBoxMaxMin and the BoneData bounds of every node with meshes at or below it,
+// bounds only grow: boxes are unioned with what the .bin had, spheres keep their centre (the bind pose centroid like
+// the importer if there was none) and take the radius reaching every sampled vertex if that's bigger
+// spaces are the importer's: submesh bounds in model space, node bounds in the node's parent space (each pose is put
+// there through the parent's world matrix in that pose)
+// clips run on their own threads, the skinning pass splits whatever cores are left over
+void UpdateAnimatedBounds(MKDXData& model, const std::vector<MotData>& clips, float samplesPerSecond, AnimBoundsReport& report);
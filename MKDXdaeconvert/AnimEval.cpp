@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "AnimEval.h"
+
+MotEvaluator::MotEvaluator(const MotData& mot)
+    : mot(mot), boneCount(mot.headerData.BoneCount)
+{
+    cursors.resize(static_cast<size_t>(boneCount) * MotChannelCount);
+    channelValues.resize(cursors.size());
+    Reset();
+}
+
+void MotEvaluator::Reset()
+{
+    for (size_t c = 0; c < cursors.size(); ++c)
+        cursors[c] = mot.channelKeyStart[c];
+}
+
+// key index k with times[k] <= frame < times[k + 1], frame has to be inside the channel's keys
+uint32_t MotEvaluator::Seek(size_t channel, float frame)
+{
+    uint32_t start = mot.channelKeyStart[channel];
+    uint32_t end = mot.channelKeyStart[channel + 1];
+    const float* times = mot.keyTimes.data();
+    uint32_t k = cursors[channel];
+
+    // playback moves a key or two per sample, only search when the cursor is far off
+    for (int step = 0; step < 4; ++step) {
+        if (times[k] > frame && k > start) k--;
+        else if (k + 1 < end && times[k + 1] <= frame) k++;
+        else return cursors[channel] = k;
+    }
+
+    k = static_cast<uint32_t>(std::upper_bound(times + start, times + end, frame) - times);
+    k = k > start ? k - 1 : start;
+    return cursors[channel] = k;
+}
+
+float MotEvaluator::Sample(uint32_t bone, int channel, float frame)
+{
+    size_t c = bone * MotChannelCount + channel;
+    uint32_t start = mot.channelKeyStart[c];
+    uint32_t end = mot.channelKeyStart[c + 1];
+    if (start == end) return mot.baseValues[c];
+
+    const float* times = mot.keyTimes.data();
+    if (frame <= times[start]) return mot.keyValues[start];
+    if (frame >= times[end - 1]) return mot.keyValues[end - 1];
+
+    uint32_t prev = Seek(c, frame);
+    uint32_t next = prev + 1;
+    float t = (frame - times[prev]) / (times[next] - times[prev]);
+    return mot.keyValues[prev] + (mot.keyValues[next] - mot.keyValues[prev]) * t;
+}
+
+const std::vector<float>& MotEvaluator::EvaluateChannels(float frame)
+{
+    for (int c = 0; c < MotChannelCount; ++c) {
+        float* out = &channelValues[static_cast<size_t>(c) * boneCount];
+        for (uint32_t b = 0; b < boneCount; ++b)
+            out[b] = Sample(b, c, frame);
+    }
+    return channelValues;
+}
+
+void MotEvaluator::EvaluateLocal(float frame, std::vector<aiMatrix4x4>& local)
+{
+    EvaluateChannels(frame);
+    local.resize(boneCount);
+    // each channel is its own contiguous array here so this loop is straight line math over 9 streams
+    for (uint32_t b = 0; b < boneCount; ++b)
+        local[b] = ComposeMotLocal(&channelValues[b], boneCount);
+}
+
+aiMatrix4x4 ComposeMotLocal(const float* values, size_t stride)
+{
+    float scaleX = values[MotScaleX * stride], scaleY = values[MotScaleY * stride], scaleZ = values[MotScaleZ * stride];
+    float cx = std::cos(values[MotRotateX * stride]), sx = std::sin(values[MotRotateX * stride]);
+    float cy = std::cos(values[MotRotateY * stride]), sy = std::sin(values[MotRotateY * stride]);
+    float cz = std::cos(values[MotRotateZ * stride]), sz = std::sin(values[MotRotateZ * stride]);
+
+    // rotZ * rotY * rotX written out, columns scaled, translation in the last column
+    aiMatrix4x4 m;
+    m.a1 = cy * cz * scaleX; m.a2 = (cz * sy * sx - sz * cx) * scaleY; m.a3 = (cz * sy * cx + sz * sx) * scaleZ;
+    m.b1 = cy * sz * scaleX; m.b2 = (sz * sy * sx + cz * cx) * scaleY; m.b3 = (sz * sy * cx - cz * sx) * scaleZ;
+    m.c1 = -sy * scaleX;     m.c2 = cy * sx * scaleY;                  m.c3 = cy * cx * scaleZ;
+    m.a4 = values[MotTranslateX * stride];
+    m.b4 = values[MotTranslateY * stride];
+    m.c4 = values[MotTranslateZ * stride];
+    m.d1 = m.d2 = m.d3 = 0.f;
+    m.d4 = 1.f;
+    return m;
+}
+
+MotPoseBinding BindMotToModel(const MotData& mot, const MKDXData& model)
+{
+    MotPoseBinding binding;
+    size_t nodeCount = model.fullNodeDataList.size();
+
+    std::unordered_map<std::string, int32_t> boneIndex;
+    for (size_t b = 0; b < mot.boneNames.size(); ++b)
+        boneIndex.emplace(mot.boneNames[b], static_cast<int32_t>(b));
+
+    binding.nodeToBone.assign(nodeCount, -1);
+    binding.parents.assign(nodeCount, -1);
+    binding.restLocal.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; ++i) {
+        auto it = boneIndex.find(model.allNodeNames[i].Name);
+        if (it != boneIndex.end()) binding.nodeToBone[i] = it->second;
+
+        const BoneData& bone = model.fullNodeDataList[i].boneData;
+        float values[MotChannelCount] = {
+            bone.Scale[0], bone.Scale[1], bone.Scale[2],
+            bone.Rotation[0], bone.Rotation[1], bone.Rotation[2],
+            bone.Translation[0], bone.Translation[1], bone.Translation[2] };
+        binding.restLocal[i] = ComposeMotLocal(values, 1);
+
+        for (auto child : model.fullNodeDataList[i].childrenIndexList)
+            binding.parents[child] = static_cast<int32_t>(i);
+    }
+
+    // breadth first from the roots so a parent's world matrix is always ready before its children
+    std::vector<uint8_t> visited(nodeCount, 0);
+    binding.order.reserve(nodeCount);
+    auto walkFrom = [&](uint32_t root) {
+        if (visited[root]) return;
+        size_t first = binding.order.size();
+        binding.order.push_back(root);
+        visited[root] = 1;
+        for (size_t k = first; k < binding.order.size(); ++k) {
+            for (auto child : model.fullNodeDataList[binding.order[k]].childrenIndexList) {
+                if (visited[child]) continue;
+                visited[child] = 1;
+                binding.order.push_back(child);
+            }
+        }
+    };
+    for (auto root : model.rootNodes) walkFrom(root);
+    for (uint32_t i = 0; i < nodeCount; ++i)
+        if (binding.parents[i] < 0) walkFrom(i);
+
+    return binding;
+}
+
+void ComposeWorldMatrices(const MotPoseBinding& binding, const std::vector<aiMatrix4x4>& boneLocal, std::vector<aiMatrix4x4>& world)
+{
+    world.resize(binding.parents.size());
+    for (auto node : binding.order) {
+        int32_t bone = binding.nodeToBone[node];
+        const aiMatrix4x4& local = bone >= 0 ? boneLocal[bone] : binding.restLocal[node];
+        int32_t parent = binding.parents[node];
+        world[node] = parent >= 0 ? world[parent] * local : local;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <assimp/matrix4x4.h>
+#include "CoolStructs.h"
+
+// samples a MotData at many frames, each channel keeps a cursor on the key it last landed on so playing
+// forwards (or backwards) only steps a key or two, a jump further than that falls back to binary search
+class MotEvaluator {
+public:
+    explicit MotEvaluator(const MotData& mot);
+
+    // cursors back to the first key of each channel
+    void Reset();
+
+    // value of one channel at a frame, linear between keys and held past the ends, base value if the channel has no keys
+    float Sample(uint32_t bone, int channel, float frame);
+
+    // every channel of every bone at frame, channel major: values[channel * BoneCount() + bone]
+    const std::vector<float>& EvaluateChannels(float frame);
+
+    // local T * Rz * Ry * Rx * S of each bone at frame, one per bone of the clip
+    void EvaluateLocal(float frame, std::vector<aiMatrix4x4>& local);
+
+    uint32_t BoneCount() const { return boneCount; }
+
+private:
+    uint32_t Seek(size_t channel, float frame);
+
+    const MotData& mot;
+    uint32_t boneCount;
+    std::vector<uint32_t> cursors; // per channel, key index whose time <= the last frame asked for
+    std::vector<float> channelValues;
+};
+
+// T * Rz * Ry * Rx * S from 9 values laid out like MotChannel, the same local transform BuildExportScene makes
+// stride is how far apart consecutive channels are (1 for one bone's 9 values, bone count for channel major arrays)
+aiMatrix4x4 ComposeMotLocal(const float* values, size_t stride);
+
+// where a clip's bones land in a model, nodes the clip doesn't animate keep their BoneData transform
+struct MotPoseBinding {
+    std::vector<int32_t> nodeToBone;       // per model node, mot bone index or -1
+    std::vector<int32_t> parents;          // per model node, -1 for roots
+    std::vector<uint32_t> order;           // nodes with parents before children
+    std::vector<aiMatrix4x4> restLocal;    // per model node
+};
+
+MotPoseBinding BindMotToModel(const MotData& mot, const MKDXData& model);
+
+// world matrix of every model node for one pose, boneLocal from MotEvaluator::EvaluateLocal
+void ComposeWorldMatrices(const MotPoseBinding& binding, const std::vector<aiMatrix4x4>& boneLocal, std::vector<aiMatrix4x4>& world);
@@ -0,0 +1,650 @@
+#include <assimp/scene.h>
+#include <assimp/Exporter.hpp>
+#include <assimp/Importer.hpp>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+// my headers
+#include "CoolStructs.h"
+#include "SaveFuncs.h"
+#include "AnimFuncs.h"
+#include "AnimEval.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+#include "IOStats.h"
+
+static const char* channelNames[MotChannelCount] = {
+    "scale x", "scale y", "scale z", "rotate x", "rotate y", "rotate z", "translate x", "translate y", "translate z"
+};
+
+static void MotError(const std::string& message) {
+    std::ofstream(logPath.c_str(), std::ios::trunc) << message;
+    throw std::runtime_error(message);
+}
+
+// bounds checked reads straight out of the mapped file
+template <typename T>
+static T ReadAt(const uint8_t* data, size_t size, size_t offset) {
+    if (offset > size || size - offset < sizeof(T))
+        MotError("Bad .mot file, read past the end at offset " + std::to_string(offset));
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+}
+
+static std::string ReadCStringAt(const uint8_t* data, size_t size, uint32_t pointer) {
+    if (pointer == 0) return std::string();
+    if (pointer >= size) MotError("Bad .mot file, name pointer past the end");
+    const void* end = std::memchr(data + pointer, '\0', size - pointer);
+    size_t length = end ? static_cast<const uint8_t*>(end) - (data + pointer) : size - pointer;
+    return std::string(reinterpret_cast<const char*>(data + pointer), length);
+}
+
+MotData ParseMotData(const uint8_t* data, size_t size) {
+    PROFILE_SCOPE("ParseMotData");
+    MotData mot;
+
+    if (size < 48 || std::memcmp(data, "BIKE", 4) != 0)
+        MotError("Invalid file signature. Expected 'BIKE'.");
+
+    MotHeader& header = mot.headerData;
+    header.Type = ReadAt<uint16_t>(data, size, 4);
+    header.Unknown = ReadAt<uint16_t>(data, size, 6);
+    header.Alignment = ReadAt<uint32_t>(data, size, 8);
+    header.Padding = ReadAt<uint32_t>(data, size, 12);
+    header.FrameOne = ReadAt<float>(data, size, 16);
+    header.FrameLast = ReadAt<float>(data, size, 20);
+    header.FirstAnimOffsetOrFramerate = ReadAt<float>(data, size, 24);
+    header.BoneCount = ReadAt<uint32_t>(data, size, 28);
+    header.BoneDataPointers = ReadAt<uint32_t>(data, size, 32);
+
+    // each bone needs an 8 byte pointer pair, catches garbage counts before anything gets sized off them
+    uint32_t boneCount = header.BoneCount;
+    if (header.BoneDataPointers > size || (size - header.BoneDataPointers) / 8 < boneCount)
+        MotError("Bad .mot file, bone table doesn't fit in the file");
+
+    size_t channelCount = static_cast<size_t>(boneCount) * MotChannelCount;
+    mot.boneNames.resize(boneCount);
+    mot.baseValues.resize(channelCount);
+    mot.channelPresent.assign(channelCount, 0);
+    mot.channelFrameOne.assign(channelCount, 0);
+    mot.channelKeyStart.assign(channelCount + 1, 0);
+    std::vector<uint32_t> keyOffsets(channelCount, 0);
+
+    // first pass reads bones + channel headers and counts keys, so the key block is sized once
+    {
+        PROFILE_SCOPE("bones + channels");
+        // summed wide, channels can point at the same keys so the per-channel checks alone don't bound the total
+        uint64_t totalKeys = 0;
+        for (uint32_t b = 0; b < boneCount; ++b) {
+            size_t entry = header.BoneDataPointers + static_cast<size_t>(b) * 8;
+            mot.boneNames[b] = ReadCStringAt(data, size, ReadAt<uint32_t>(data, size, entry));
+            size_t dataOffset = ReadAt<uint32_t>(data, size, entry + 4);
+
+            for (int c = 0; c < MotChannelCount; ++c)
+                mot.baseValues[b * MotChannelCount + c] = ReadAt<float>(data, size, dataOffset + c * 4);
+
+            for (int c = 0; c < MotChannelCount; ++c) {
+                size_t channel = b * MotChannelCount + c;
+                mot.channelKeyStart[channel] = static_cast<uint32_t>(totalKeys);
+
+                size_t animOffset = ReadAt<uint32_t>(data, size, dataOffset + 36 + c * 4);
+                if (animOffset == 0) continue;
+
+                mot.channelPresent[channel] = 1;
+                mot.channelFrameOne[channel] = ReadAt<uint32_t>(data, size, animOffset);
+                uint32_t keyCount = ReadAt<uint32_t>(data, size, animOffset + 4);
+                uint32_t keyOffset = ReadAt<uint32_t>(data, size, animOffset + 8);
+                if (keyOffset > size || (size - keyOffset) / 8 < keyCount)
+                    MotError("Bad .mot file, keys of " + mot.boneNames[b] + " " + channelNames[c] + " run past the end");
+
+                keyOffsets[channel] = keyOffset;
+                totalKeys += keyCount;
+                if (totalKeys > size / 8 || totalKeys > UINT32_MAX)
+                    MotError("Bad .mot file, more keys than the file has room for");
+            }
+        }
+        mot.channelKeyStart[channelCount] = static_cast<uint32_t>(totalKeys);
+    }
+
+    // second pass splits the (index, value) pairs into the time and value arrays
+    {
+        PROFILE_SCOPE("keys");
+        mot.keyTimes.resize(mot.channelKeyStart[channelCount]);
+        mot.keyValues.resize(mot.channelKeyStart[channelCount]);
+        for (size_t channel = 0; channel < channelCount; ++channel) {
+            uint32_t start = mot.channelKeyStart[channel];
+            uint32_t count = mot.channelKeyStart[channel + 1] - start;
+            const uint8_t* keys = data + keyOffsets[channel];
+            for (uint32_t k = 0; k < count; ++k) {
+                std::memcpy(&mot.keyTimes[start + k], keys + k * 8, 4);
+                std::memcpy(&mot.keyValues[start + k], keys + k * 8 + 4, 4);
+            }
+        }
+    }
+
+    return mot;
+}
+
+MotData LoadMotFile(const std::string& path) {
+    PROFILE_SCOPE("LoadMotFile");
+    MappedFile file;
+    if (!file.Open(path))
+        MotError("Error: failed to open " + path);
+    return ParseMotData(file.Data(), file.Size());
+}
+
+void PrintMotSummary(const std::string& name, const MotData& mot) {
+    size_t animatedChannels = 0;
+    for (uint8_t present : mot.channelPresent) animatedChannels += present;
+
+    std::cout << std::dec << "\033[34m" << name << "\033[37m: " << mot.headerData.BoneCount << " bones, frames "
+        << mot.headerData.FrameOne << " - " << mot.headerData.FrameLast << ", "
+        << animatedChannels << " animated channels, " << mot.keyTimes.size() << " keys\n";
+
+    for (uint32_t b = 0; b < mot.headerData.BoneCount; ++b) {
+        std::cout << "  " << mot.boneNames[b] << ":";
+        bool any = false;
+        for (int c = 0; c < MotChannelCount; ++c) {
+            if (!mot.channelPresent[b * MotChannelCount + c]) continue;
+            std::cout << (any ? ", " : " ") << channelNames[c] << " (" << MotKeyCount(mot, b, c) << ")";
+            any = true;
+        }
+        std::cout << (any ? "\n" : " static\n");
+    }
+}
+
+// sorted key times of the x/y/z channels starting at firstChannel, empty if none of them are keyed
+static std::vector<float> UnionKeyTimes(const MotData& mot, uint32_t bone, int firstChannel) {
+    std::vector<float> times;
+    for (int c = firstChannel; c < firstChannel + 3; ++c) {
+        size_t channel = bone * MotChannelCount + c;
+        times.insert(times.end(), mot.keyTimes.begin() + mot.channelKeyStart[channel], mot.keyTimes.begin() + mot.channelKeyStart[channel + 1]);
+    }
+    std::sort(times.begin(), times.end());
+    times.erase(std::unique(times.begin(), times.end()), times.end());
+    return times;
+}
+
+// same as rotZ * rotY * rotX in BuildExportScene
+static aiQuaternion EulerZYXToQuaternion(float x, float y, float z) {
+    float cx = std::cos(x * 0.5f), sx = std::sin(x * 0.5f);
+    float cy = std::cos(y * 0.5f), sy = std::sin(y * 0.5f);
+    float cz = std::cos(z * 0.5f), sz = std::sin(z * 0.5f);
+    return aiQuaternion(
+        cz * cy * cx + sz * sy * sx,
+        cz * cy * sx - sz * sy * cx,
+        cz * sy * cx + sz * cy * sx,
+        sz * cy * cx - cz * sy * sx);
+}
+
+static aiVectorKey* SampleVectorKeys(const MotData& mot, MotEvaluator& eval, uint32_t bone, int firstChannel, unsigned int& count) {
+    std::vector<float> times = UnionKeyTimes(mot, bone, firstChannel);
+    if (times.empty()) times.push_back(mot.headerData.FrameOne);
+
+    count = static_cast<unsigned int>(times.size());
+    aiVectorKey* keys = new aiVectorKey[count];
+    for (unsigned int i = 0; i < count; ++i) {
+        keys[i].mTime = times[i];
+        keys[i].mValue = aiVector3D(
+            eval.Sample(bone, firstChannel, times[i]),
+            eval.Sample(bone, firstChannel + 1, times[i]),
+            eval.Sample(bone, firstChannel + 2, times[i]));
+    }
+    return keys;
+}
+
+aiAnimation* BuildMotAnimation(const MotData& mot, const std::string& clipName, const std::unordered_set<std::string>* nodeNames) {
+    PROFILE_SCOPE("BuildMotAnimation");
+    aiAnimation* anim = new aiAnimation();
+    anim->mName = clipName;
+    anim->mTicksPerSecond = 60.0; // keys are frame numbers, game runs at 60
+    anim->mDuration = std::max(0.f, mot.headerData.FrameLast);
+
+    MotEvaluator eval(mot); // every group is sampled in increasing time so the cursors just walk forward
+    std::vector<aiNodeAnim*> channels;
+    size_t skipped = 0;
+    for (uint32_t b = 0; b < mot.headerData.BoneCount; ++b) {
+        bool animated = false;
+        for (int c = 0; c < MotChannelCount && !animated; ++c)
+            animated = MotKeyCount(mot, b, c) > 0;
+        if (!animated) continue;
+
+        if (nodeNames && !nodeNames->count(mot.boneNames[b])) {
+            skipped++;
+            continue;
+        }
+
+        aiNodeAnim* nodeAnim = new aiNodeAnim();
+        nodeAnim->mNodeName = mot.boneNames[b];
+        nodeAnim->mPositionKeys = SampleVectorKeys(mot, eval, b, MotTranslateX, nodeAnim->mNumPositionKeys);
+        nodeAnim->mScalingKeys = SampleVectorKeys(mot, eval, b, MotScaleX, nodeAnim->mNumScalingKeys);
+
+        std::vector<float> times = UnionKeyTimes(mot, b, MotRotateX);
+        if (times.empty()) times.push_back(mot.headerData.FrameOne);
+        nodeAnim->mNumRotationKeys = static_cast<unsigned int>(times.size());
+        nodeAnim->mRotationKeys = new aiQuatKey[times.size()];
+        for (size_t i = 0; i < times.size(); ++i) {
+            nodeAnim->mRotationKeys[i].mTime = times[i];
+            nodeAnim->mRotationKeys[i].mValue = EulerZYXToQuaternion(
+                eval.Sample(b, MotRotateX, times[i]),
+                eval.Sample(b, MotRotateY, times[i]),
+                eval.Sample(b, MotRotateZ, times[i]));
+        }
+        channels.push_back(nodeAnim);
+    }
+
+    if (skipped > 0)
+        std::cout << skipped << " animated bone(s) of " << clipName << " aren't in the model, skipped\n";
+
+    anim->mNumChannels = static_cast<unsigned int>(channels.size());
+    anim->mChannels = new aiNodeAnim * [channels.size()];
+    std::copy(channels.begin(), channels.end(), anim->mChannels);
+    return anim;
+}
+
+std::string FindMotModel(const MotData& mot, const std::vector<std::string>& binPaths,
+    std::unordered_map<std::string, std::unordered_set<std::string>>& nodeNameCache) {
+    PROFILE_SCOPE("FindMotModel");
+    std::string best;
+    size_t bestMatches = 0;
+
+    for (const auto& path : binPaths) {
+        auto it = nodeNameCache.find(path);
+        if (it == nodeNameCache.end()) {
+            std::unordered_set<std::string> names;
+            std::ifstream fs(path, std::ios::binary);
+            if (fs) {
+                try {
+                    MKDXData data = LoadMKDXLayout(fs); // names are in the layout, no buffers needed
+                    for (const auto& n : data.allNodeNames) names.insert(n.Name);
+                }
+                catch (...) {
+                    // not a model we can read, just never matches
+                }
+            }
+            it = nodeNameCache.emplace(path, std::move(names)).first;
+        }
+
+        size_t matches = 0;
+        for (const auto& name : mot.boneNames)
+            matches += it->second.count(name);
+        if (matches > bestMatches) {
+            best = path;
+            bestMatches = matches;
+            if (matches == mot.boneNames.size()) break;
+        }
+    }
+    return best;
+}
+
+// Scene -> Armature -> one node per clip bone at its base pose, for clips with no model to go on
+static aiScene* BuildMotSkeletonScene(const MotData& mot) {
+    aiScene* scene = new aiScene();
+    scene->mRootNode = new aiNode();
+    scene->mRootNode->mName = "Scene";
+
+    aiNode* armatureNode = new aiNode();
+    armatureNode->mName = "Armature";
+    armatureNode->mParent = scene->mRootNode;
+    scene->mRootNode->mNumChildren = 1;
+    scene->mRootNode->mChildren = new aiNode * [1] { armatureNode };
+
+    uint32_t boneCount = mot.headerData.BoneCount;
+    armatureNode->mNumChildren = boneCount;
+    armatureNode->mChildren = new aiNode * [boneCount];
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        const float* base = &mot.baseValues[b * MotChannelCount];
+        aiNode* node = new aiNode();
+        node->mName = mot.boneNames[b];
+        node->mTransformation = aiMatrix4x4(aiVector3D(base[MotScaleX], base[MotScaleY], base[MotScaleZ]),
+            EulerZYXToQuaternion(base[MotRotateX], base[MotRotateY], base[MotRotateZ]),
+            aiVector3D(base[MotTranslateX], base[MotTranslateY], base[MotTranslateZ]));
+        node->mParent = armatureNode;
+        armatureNode->mChildren[b] = node;
+    }
+    return scene;
+}
+
+void SaveMotAnimation(const std::string& motPath, const std::string& outDir, const MotData& mot, MKDXData* model) {
+    PROFILE_SCOPE("SaveMotAnimation");
+    std::string clipName = motPath.substr(motPath.find_last_of("/\\") + 1);
+    clipName = clipName.substr(0, clipName.find_last_of('.'));
+
+    std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>> allMaterialToIndices;
+    std::unordered_set<std::string> nodeNames;
+    aiScene* scene = nullptr;
+    if (model) {
+        scene = BuildExportScene(model->headerData, model->materialsData, model->textureNames, model->nodeLinks,
+            model->allNodeNames, model->rootNodes, model->fullNodeDataList, true, allMaterialToIndices);
+        for (const auto& n : model->allNodeNames) nodeNames.insert(n.Name);
+    }
+    else {
+        scene = BuildMotSkeletonScene(mot);
+        nodeNames.insert(mot.boneNames.begin(), mot.boneNames.end());
+    }
+
+    scene->mNumAnimations = 1;
+    scene->mAnimations = new aiAnimation * [1] { BuildMotAnimation(mot, clipName, &nodeNames) };
+
+    std::string basePath = motPath.substr(0, motPath.find_last_of('.')) + "_anim";
+    std::string daePath = MakeOutFilePath(basePath + ".dae", outDir);
+    std::string glbPath = MakeOutFilePath(basePath + ".glb", outDir);
+    {
+        PROFILE_SCOPE("assimp export");
+        Assimp::Exporter exporter;
+        if (exporter.Export(scene, "collada", daePath) != aiReturn_SUCCESS)
+            std::cerr << "Failed to write " << daePath << ": " << exporter.GetErrorString() << "\n";
+        if (exporter.Export(scene, "glb2", glbPath) != aiReturn_SUCCESS)
+            std::cerr << "Failed to write " << glbPath << ": " << exporter.GetErrorString() << "\n";
+    }
+
+    // same material fix up as a normal model export
+    if (model) {
+        PROFILE_SCOPE("PatchDaeFile");
+        CallPatchDaeFileDLL(daePath, allMaterialToIndices);
+    }
+
+    delete scene;
+    std::cout << "Saved animation " << clipName << " to " << daePath << " and " << glbPath << "\n";
+}
+
+void SaveMotFile(const std::string& path, const MotData& mot) {
+    PROFILE_SCOPE("SaveMotFile");
+    uint32_t boneCount = mot.headerData.BoneCount;
+    size_t channelCount = static_cast<size_t>(boneCount) * MotChannelCount;
+
+    // lay everything out first so each offset is known before it gets written
+    uint32_t tableOffset = 48;
+    uint32_t pos = tableOffset + boneCount * 8;
+    std::vector<uint32_t> namePointers(boneCount);
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        namePointers[b] = pos;
+        pos += static_cast<uint32_t>(mot.boneNames[b].size()) + 1;
+    }
+    uint32_t namesEnd = pos;
+    pos = (pos + 15) & ~15u;
+    uint32_t boneDataOffset = pos;
+    pos += boneCount * 72;
+
+    std::vector<uint32_t> channelOffsets(channelCount, 0);
+    for (size_t channel = 0; channel < channelCount; ++channel) {
+        if (!mot.channelPresent[channel]) continue;
+        channelOffsets[channel] = pos;
+        pos += 12 + (mot.channelKeyStart[channel + 1] - mot.channelKeyStart[channel]) * 8;
+    }
+
+    std::ofstream writer(path, std::ios::binary);
+    if (!writer) {
+        std::ofstream(logPath.c_str(), std::ios::trunc) << "Error: couldn't write " << path;
+        throw std::runtime_error("couldn't write " + path);
+    }
+
+    const MotHeader& header = mot.headerData;
+    uint32_t zeros[3] = { 0, 0, 0 };
+    WriteBytes(writer, "BIKE", 4);
+    WriteBytes(writer, &header.Type, sizeof(uint16_t));
+    WriteBytes(writer, &header.Unknown, sizeof(uint16_t));
+    WriteBytes(writer, &header.Alignment, sizeof(uint32_t));
+    WriteBytes(writer, &header.Padding, sizeof(uint32_t));
+    WriteBytes(writer, &header.FrameOne, sizeof(float));
+    WriteBytes(writer, &header.FrameLast, sizeof(float));
+    WriteBytes(writer, &header.FirstAnimOffsetOrFramerate, sizeof(float));
+    WriteBytes(writer, &boneCount, sizeof(uint32_t));
+    WriteBytes(writer, &tableOffset, sizeof(uint32_t));
+    WriteBytes(writer, zeros, sizeof(zeros));
+
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        uint32_t dataOffset = boneDataOffset + b * 72;
+        WriteBytes(writer, &namePointers[b], sizeof(uint32_t));
+        WriteBytes(writer, &dataOffset, sizeof(uint32_t));
+    }
+    for (const auto& name : mot.boneNames)
+        WriteBytes(writer, name.c_str(), name.size() + 1);
+    if (boneDataOffset > namesEnd)
+        WriteBytes(writer, std::vector<char>(boneDataOffset - namesEnd, 0).data(), boneDataOffset - namesEnd);
+
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        WriteBytes(writer, &mot.baseValues[b * MotChannelCount], MotChannelCount * sizeof(float));
+        WriteBytes(writer, &channelOffsets[b * MotChannelCount], MotChannelCount * sizeof(uint32_t));
+    }
+
+    for (size_t channel = 0; channel < channelCount; ++channel) {
+        if (!mot.channelPresent[channel]) continue;
+        uint32_t start = mot.channelKeyStart[channel];
+        uint32_t count = mot.channelKeyStart[channel + 1] - start;
+        uint32_t keyOffset = channelOffsets[channel] + 12;
+        WriteBytes(writer, &mot.channelFrameOne[channel], sizeof(uint32_t));
+        WriteBytes(writer, &count, sizeof(uint32_t));
+        WriteBytes(writer, &keyOffset, sizeof(uint32_t));
+        for (uint32_t k = start; k < start + count; ++k) {
+            WriteBytes(writer, &mot.keyTimes[k], sizeof(float));
+            WriteBytes(writer, &mot.keyValues[k], sizeof(float));
+        }
+    }
+}
+
+void ReduceMotKeys(std::vector<float>& times, std::vector<float>& values, float tolerance) {
+    size_t count = times.size();
+    if (count < 3) return;
+
+    std::vector<uint8_t> keep(count, 0);
+    keep[0] = keep[count - 1] = 1;
+
+    // split on the key furthest from the line between the ends of each span until every span fits
+    std::vector<std::pair<size_t, size_t>> spans = { { 0, count - 1 } };
+    while (!spans.empty()) {
+        size_t first = spans.back().first, last = spans.back().second;
+        spans.pop_back();
+        if (last - first < 2) continue;
+
+        float span = times[last] - times[first];
+        size_t worst = first;
+        float worstError = 0.f;
+        for (size_t k = first + 1; k < last; ++k) {
+            float t = span > 0.f ? (times[k] - times[first]) / span : 0.f;
+            float error = std::fabs(values[first] + (values[last] - values[first]) * t - values[k]);
+            if (error > worstError) {
+                worstError = error;
+                worst = k;
+            }
+        }
+
+        if (worstError > tolerance) {
+            keep[worst] = 1;
+            spans.push_back({ first, worst });
+            spans.push_back({ worst, last });
+        }
+    }
+
+    size_t out = 0;
+    for (size_t k = 0; k < count; ++k) {
+        if (!keep[k]) continue;
+        times[out] = times[k];
+        values[out] = values[k];
+        out++;
+    }
+    times.resize(out);
+    values.resize(out);
+}
+
+// largest gap between the original keys and linear interpolation of the reduced ones
+static float MaxReductionError(const std::vector<float>& origTimes, const std::vector<float>& origValues,
+    const std::vector<float>& times, const std::vector<float>& values) {
+    float worst = 0.f;
+    size_t next = 0;
+    for (size_t k = 0; k < origTimes.size(); ++k) {
+        float t = origTimes[k];
+        while (next < times.size() && times[next] < t) next++;
+        float value;
+        if (next == 0) value = values.front();
+        else if (next == times.size()) value = values.back();
+        else {
+            float span = times[next] - times[next - 1];
+            value = values[next - 1] + (values[next] - values[next - 1]) * (span > 0.f ? (t - times[next - 1]) / span : 0.f);
+        }
+        worst = std::max(worst, std::fabs(value - origValues[k]));
+    }
+    return worst;
+}
+
+static aiVector3D QuaternionToEulerZYX(const aiQuaternion& q) {
+    return MatrixToEulerZYX(aiMatrix4x4(aiVector3D(1.f, 1.f, 1.f), q, aiVector3D(0.f, 0.f, 0.f)));
+}
+
+// nearest equivalent of angle to previous, stops euler tracks jumping by 2pi between keys
+static float UnwrapAngle(float angle, float previous) {
+    const float twoPi = static_cast<float>(AI_MATH_PI * 2.0);
+    while (angle - previous > AI_MATH_PI) angle -= twoPi;
+    while (angle - previous < -AI_MATH_PI) angle += twoPi;
+    return angle;
+}
+
+MotData BuildMotFromAnimation(const aiScene* scene, const aiAnimation* anim, float tolLinear, float tolAngleRadians, MotReduceReport& report) {
+    PROFILE_SCOPE("BuildMotFromAnimation");
+    MotData mot;
+
+    // keys to frames, the game runs at 60 and assimp means 25 when it doesn't say
+    double ticksPerSecond = anim->mTicksPerSecond > 0 ? anim->mTicksPerSecond : 25.0;
+    auto toFrame = [&](double ticks) { return static_cast<float>(ticks / ticksPerSecond * 60.0); };
+
+    uint32_t boneCount = anim->mNumChannels;
+    mot.headerData.BoneCount = boneCount;
+    mot.headerData.FrameLast = toFrame(anim->mDuration);
+    mot.boneNames.resize(boneCount);
+    mot.baseValues.assign(static_cast<size_t>(boneCount) * MotChannelCount, 0.f);
+    mot.channelPresent.assign(static_cast<size_t>(boneCount) * MotChannelCount, 0);
+    mot.channelFrameOne.assign(static_cast<size_t>(boneCount) * MotChannelCount, 0);
+    mot.channelKeyStart.assign(static_cast<size_t>(boneCount) * MotChannelCount + 1, 0);
+
+    for (uint32_t b = 0; b < boneCount; ++b) {
+        const aiNodeAnim* nodeAnim = anim->mChannels[b];
+        mot.boneNames[b] = nodeAnim->mNodeName.C_Str();
+        float* base = &mot.baseValues[b * MotChannelCount];
+
+        // base pose is the node's own local transform
+        base[MotScaleX] = base[MotScaleY] = base[MotScaleZ] = 1.f;
+        if (const aiNode* node = scene->mRootNode ? scene->mRootNode->FindNode(nodeAnim->mNodeName.C_Str()) : nullptr) {
+            aiVector3D scale, position;
+            aiQuaternion rotation;
+            node->mTransformation.Decompose(scale, rotation, position);
+            aiVector3D euler = MatrixToEulerZYX(node->mTransformation);
+            float values[MotChannelCount] = { scale.x, scale.y, scale.z, euler.x, euler.y, euler.z, position.x, position.y, position.z };
+            std::copy(values, values + MotChannelCount, base);
+        }
+
+        // split the vector/quaternion keys into the nine scalar channels
+        std::vector<float> times[MotChannelCount], values[MotChannelCount];
+        for (unsigned int k = 0; k < nodeAnim->mNumScalingKeys; ++k) {
+            const aiVectorKey& key = nodeAnim->mScalingKeys[k];
+            float v[3] = { key.mValue.x, key.mValue.y, key.mValue.z };
+            for (int c = 0; c < 3; ++c) {
+                times[MotScaleX + c].push_back(toFrame(key.mTime));
+                values[MotScaleX + c].push_back(v[c]);
+            }
+        }
+        for (unsigned int k = 0; k < nodeAnim->mNumRotationKeys; ++k) {
+            const aiQuatKey& key = nodeAnim->mRotationKeys[k];
+            aiVector3D euler = QuaternionToEulerZYX(key.mValue);
+            float v[3] = { euler.x, euler.y, euler.z };
+            for (int c = 0; c < 3; ++c) {
+                std::vector<float>& channelValues = values[MotRotateX + c];
+                times[MotRotateX + c].push_back(toFrame(key.mTime));
+                channelValues.push_back(channelValues.empty() ? v[c] : UnwrapAngle(v[c], channelValues.back()));
+            }
+        }
+        for (unsigned int k = 0; k < nodeAnim->mNumPositionKeys; ++k) {
+            const aiVectorKey& key = nodeAnim->mPositionKeys[k];
+            float v[3] = { key.mValue.x, key.mValue.y, key.mValue.z };
+            for (int c = 0; c < 3; ++c) {
+                times[MotTranslateX + c].push_back(toFrame(key.mTime));
+                values[MotTranslateX + c].push_back(v[c]);
+            }
+        }
+
+        for (int c = 0; c < MotChannelCount; ++c) {
+            size_t channel = b * MotChannelCount + c;
+            mot.channelKeyStart[channel] = static_cast<uint32_t>(mot.keyTimes.size());
+            if (times[c].empty()) continue;
+
+            bool isRotation = c >= MotRotateX && c <= MotRotateZ;
+            float tolerance = isRotation ? tolAngleRadians : tolLinear;
+            report.keysBefore += times[c].size();
+
+            // a channel that never leaves its first value just becomes the base value
+            float first = values[c].front();
+            bool constant = true;
+            for (float v : values[c]) constant = constant && std::fabs(v - first) <= tolerance;
+            if (constant) {
+                base[c] = first;
+                continue;
+            }
+
+            std::vector<float> reducedTimes = times[c], reducedValues = values[c];
+            ReduceMotKeys(reducedTimes, reducedValues, tolerance);
+
+            float error = MaxReductionError(times[c], values[c], reducedTimes, reducedValues);
+            if (isRotation) report.maxAngleError = std::max(report.maxAngleError, error);
+            else report.maxLinearError = std::max(report.maxLinearError, error);
+            report.keysAfter += reducedTimes.size();
+
+            mot.channelPresent[channel] = 1;
+            mot.keyTimes.insert(mot.keyTimes.end(), reducedTimes.begin(), reducedTimes.end());
+            mot.keyValues.insert(mot.keyValues.end(), reducedValues.begin(), reducedValues.end());
+        }
+    }
+    mot.channelKeyStart.back() = static_cast<uint32_t>(mot.keyTimes.size());
+    return mot;
+}
+
+void ImportMotAnimations(const std::string& path, const std::string& outDir, float tolLinear, float tolAngleDegrees) {
+    PROFILE_SCOPE("ImportMotAnimations");
+    std::string fileName = path.substr(path.find_last_of("/\\") + 1);
+
+    Assimp::Importer importer;
+    const aiScene* scene = nullptr;
+    {
+        PROFILE_SCOPE("assimp read");
+        scene = importer.ReadFile(path, 0);
+    }
+    if (!scene) {
+        std::cerr << "Error: couldn't read " << fileName << ": " << importer.GetErrorString() << "\n";
+        std::ofstream(logPath.c_str(), std::ios::trunc) << "Error: couldn't read " << fileName << "\n" << importer.GetErrorString();
+        return;
+    }
+    if (!scene->HasAnimations()) {
+        std::cerr << "Error: " << fileName << " has no animations\n";
+        std::ofstream(logPath.c_str(), std::ios::trunc) << "Error: " << fileName << " has no animations";
+        return;
+    }
+
+    float tolAngleRadians = static_cast<float>(tolAngleDegrees * AI_MATH_PI / 180.0);
+    std::string stem = path.substr(0, path.find_last_of('.'));
+    std::ostringstream log;
+
+    for (unsigned int i = 0; i < scene->mNumAnimations; ++i) {
+        const aiAnimation* anim = scene->mAnimations[i];
+        MotReduceReport report;
+        MotData mot = BuildMotFromAnimation(scene, anim, tolLinear, tolAngleRadians, report);
+
+        std::string outPath = MakeOutFilePath(stem + (scene->mNumAnimations > 1 ? "_" + std::to_string(i) : "") + "_out.mot", outDir);
+        SaveMotFile(outPath, mot);
+
+        double percent = report.keysBefore ? 100.0 * report.keysAfter / report.keysBefore : 0.0;
+        std::cout << std::dec << "\n\033[34m" << (anim->mName.length ? anim->mName.C_Str() : fileName.c_str()) << "\033[37m: "
+            << mot.headerData.BoneCount << " bones, " << mot.headerData.FrameLast << " frames\n"
+            << "  keys " << report.keysBefore << " -> " << report.keysAfter << " (" << percent << "%)\n"
+            << "  max error " << report.maxLinearError << " linear, " << report.maxAngleError * 180.0 / AI_MATH_PI << " degrees\n"
+            << "  saved to " << outPath << "\n";
+        log << "Saved animation to " << outPath << "\n" << report.keysBefore << " keys reduced to " << report.keysAfter << "\n";
+    }
+
+    std::ofstream(logPath.c_str(), std::ios::trunc) << log.str();
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include <assimp/matrix4x4.h>
+#include "CoolStructs.h"
+
+struct aiScene;
+struct aiAnimation;
+
+// maps the .mot and packs every channel into MotData's key arrays, throws on a bad file like LoadMKDXFile
+MotData LoadMotFile(const std::string& path);
+MotData ParseMotData(const uint8_t* data, size_t size);
+
+inline uint32_t MotKeyCount(const MotData& mot, uint32_t bone, int channel) {
+    size_t c = bone * MotChannelCount + channel;
+    return mot.channelKeyStart[c + 1] - mot.channelKeyStart[c];
+}
+
+void PrintMotSummary(const std::string& name, const MotData& mot);
+
+// one aiNodeAnim per animated bone, translate/scale keyed on the union of their xyz key times and rotation turned into
+// quaternions the same Z * Y * X way BuildExportScene does, groups with no keys get a single base value key
+// bones not in nodeNames are skipped (nullptr = keep all)
+aiAnimation* BuildMotAnimation(const MotData& mot, const std::string& clipName, const std::unordered_set<std::string>* nodeNames);
+
+// picks the .bin whose node names cover the most bones of the clip, empty if none share a name
+// node names of every .bin read (layout only, no buffers) are kept in nodeNameCache so a folder of clips only reads each model once
+std::string FindMotModel(const MotData& mot, const std::vector<std::string>& binPaths,
+    std::unordered_map<std::string, std::unordered_set<std::string>>& nodeNameCache);
+
+// writes <clip>_anim.dae and <clip>_anim.glb, with the model's skeleton + meshes or a flat skeleton of the clip's bones if model is null
+void SaveMotAnimation(const std::string& motPath, const std::string& outDir, const MotData& mot, MKDXData* model);
+
+// CoolStuff.cpp, euler angles in the rotZ * rotY * rotX order the model nodes use
+aiVector3D MatrixToEulerZYX(const aiMatrix4x4& M);
+
+// writes the .mot layout back out, bone table then names, bone data, and each channel header followed by its keys
+void SaveMotFile(const std::string& path, const MotData& mot);
+
+// drops keys of one scalar channel while linear interpolation of what's left stays within tolerance of every original key
+// (Douglas-Peucker on value vs time), first and last keys always stay
+void ReduceMotKeys(std::vector<float>& times, std::vector<float>& values, float tolerance);
+
+struct MotReduceReport {
+    size_t keysBefore = 0;
+    size_t keysAfter = 0;
+    float maxLinearError = 0.f;
+    float maxAngleError = 0.f; // radians
+};
+
+// one clip of the scene as .mot, bones are the animated nodes with their local transform as base values
+MotData BuildMotFromAnimation(const aiScene* scene, const aiAnimation* anim, float tolLinear, float tolAngleRadians, MotReduceReport& report);
+
+// reads every animation of a .dae/.fbx and saves each as <name>_out.mot (<name>_<i>_out.mot when there's more than one)
+void ImportMotAnimations(const std::string& path, const std::string& outDir, float tolLinear, float tolAngleDegrees);
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "CoolStructs.h"
+
+// 64 bit FNV-1a, equal hashes still get a byte compare wherever both buffers are around to compare
+const uint64_t ContentHashSeed = 14695981039346656037ull;
+
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t hash = ContentHashSeed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// a second hash that shares nothing with HashBytes (8 byte words, multiply + rotate), for where the buffers are gone
+// by the time a match turns up so two different hashes have to stand in for the byte compare
+inline uint64_t HashBytesMix(const void* data, size_t size, uint64_t hash = ContentHashSeed)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    auto mix = [&hash](uint64_t word) {
+        hash ^= word * 0x9E3779B97F4A7C15ull;
+        hash = ((hash << 31) | (hash >> 33)) * 0xC2B2AE3D27D4EB4Full;
+    };
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, bytes + i, 8);
+        mix(word);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, bytes + i, size - i);
+    mix(tail ^ (static_cast<uint64_t>(size - i) << 56));
+    return hash;
+}
+
+typedef uint64_t (*ByteHash)(const void* data, size_t size, uint64_t hash);
+
+template <typename T>
+inline uint64_t HashBuffer(const std::vector<T>& buffer, uint64_t hash = ContentHashSeed, ByteHash hashBytes = HashBytes)
+{
+    uint64_t size = buffer.size();
+    hash = hashBytes(&size, sizeof(size), hash);
+    return hashBytes(buffer.data(), buffer.size() * sizeof(T), hash);
+}
+
+// byte for byte, so it agrees with the hash on things like -0.f and NaN that == would not
+template <typename T>
+inline bool SameBuffer(const std::vector<T>& a, const std::vector<T>& b)
+{
+    return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+// the buffers of submesh s that get exported, null where the node's list has no entry for it
+inline void ExportedBuffers(const FullNodeData& node, size_t s, const std::vector<float>* out[7], const std::vector<uint16_t>*& polys)
+{
+    const std::vector<std::vector<float>>* lists[7] = { &node.verticesList, &node.normalsList, &node.colorsList,
+        &node.uvs0List, &node.uvs1List, &node.uvs2List, &node.uvs3List };
+    for (int i = 0; i < 7; ++i) out[i] = s < lists[i]->size() ? &(*lists[i])[s] : nullptr;
+    polys = s < node.polygonsList.size() ? &node.polygonsList[s] : nullptr;
+}
+
+// everything submesh s exports apart from its node (buffers, vertex count and material), for finding repeated geometry
+inline uint64_t HashSubMeshContent(const FullNodeData& node, size_t s, uint64_t hash = ContentHashSeed, ByteHash hashBytes = HashBytes)
+{
+    const SubMesh& sub = node.subMeshes[s];
+    uint32_t header[2] = { sub.VertexCount, sub.MaterialIndex };
+    hash = hashBytes(header, sizeof(header), hash);
+
+    const std::vector<float>* buffers[7];
+    const std::vector<uint16_t>* polys;
+    ExportedBuffers(node, s, buffers, polys);
+    for (const std::vector<float>* buffer : buffers) {
+        uint8_t present = buffer != nullptr;
+        hash = hashBytes(&present, 1, hash);
+        if (buffer) hash = HashBuffer(*buffer, hash, hashBytes);
+    }
+    return polys ? HashBuffer(*polys, hash, hashBytes) : hash;
+}
+
+// bytes of everything HashSubMeshContent covers, one more thing that has to agree when only hashes can be compared
+inline size_t SubMeshContentBytes(const FullNodeData& node, size_t s)
+{
+    const std::vector<float>* buffers[7];
+    const std::vector<uint16_t>* polys;
+    ExportedBuffers(node, s, buffers, polys);
+    size_t bytes = 0;
+    for (const std::vector<float>* buffer : buffers)
+        if (buffer) bytes += buffer->size() * sizeof(float);
+    return polys ? bytes + polys->size() * sizeof(uint16_t) : bytes;
+}
+
+inline bool SameSubMeshContent(const FullNodeData& a, size_t sa, const FullNodeData& b, size_t sb)
+{
+    if (a.subMeshes[sa].VertexCount != b.subMeshes[sb].VertexCount || a.subMeshes[sa].MaterialIndex != b.subMeshes[sb].MaterialIndex)
+        return false;
+
+    const std::vector<float>* buffersA[7];
+    const std::vector<float>* buffersB[7];
+    const std::vector<uint16_t>* polysA;
+    const std::vector<uint16_t>* polysB;
+    ExportedBuffers(a, sa, buffersA, polysA);
+    ExportedBuffers(b, sb, buffersB, polysB);
+    for (int i = 0; i < 7; ++i) {
+        if (!buffersA[i] != !buffersB[i]) return false;
+        if (buffersA[i] && !SameBuffer(*buffersA[i], *buffersB[i])) return false;
+    }
+    if (!polysA != !polysB) return false;
+    return !polysA || SameBuffer(*polysA, *polysB);
+}
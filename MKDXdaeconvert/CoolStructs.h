@@ -107,6 +107,39 @@ struct MKDXData {
 	std::vector<NodeNames> boneNames;
 };
 
+// .mot animation files, layout in "MKDX anims.bt"
+struct MotHeader {
+    uint16_t Type = 0;
+    uint16_t Unknown = 0;
+    uint32_t Alignment = 16;
+    uint32_t Padding = 0;
+    float FrameOne = 0.f;
+    float FrameLast = 0.f;
+    float FirstAnimOffsetOrFramerate = 0.f; // not sure which yet
+    uint32_t BoneCount = 0;
+    uint32_t BoneDataPointers = 0;
+};
+
+// per bone channel order, same as the 9 anim offsets after the base SRT
+enum MotChannel {
+    MotScaleX, MotScaleY, MotScaleZ,
+    MotRotateX, MotRotateY, MotRotateZ,
+    MotTranslateX, MotTranslateY, MotTranslateZ,
+    MotChannelCount
+};
+
+// every key of a file in one block, channel c of bone b owns keys [channelKeyStart[b * 9 + c], channelKeyStart[b * 9 + c + 1])
+struct MotData {
+    MotHeader headerData;
+    std::vector<std::string> boneNames;
+    std::vector<float> baseValues;          // 9 per bone, scale xyz rotate xyz translate xyz
+    std::vector<uint8_t> channelPresent;    // 9 per bone, anim offset was non zero
+    std::vector<uint32_t> channelFrameOne;  // 9 per bone, FrameOne field of the channel
+    std::vector<uint32_t> channelKeyStart;  // 9 per bone + 1
+    std::vector<float> keyTimes;
+    std::vector<float> keyValues;
+};
+
 struct Vec3 {
     float x, y, z;
 };
@@ -123,4 +156,36 @@ struct MaterialPreset {
     int texEnvironment = -1;
     int texNormal = -1;
     float unknownVal2 = 50.f;
-};
\ No newline at end of file
+};
+
+// what a .bin export writes, picked with --formats=
+enum ExportFormat : uint32_t {
+    ExportDae = 1 << 0,
+    ExportFbx = 1 << 1,     // FbxConverter run on the patched .dae
+    ExportGltf = 1 << 2,
+    ExportGlb = 1 << 3,
+    ExportPreset = 1 << 4,
+    ExportNormals = 1 << 5, // _normals.bin + Maya loader script
+    ExportDefault = ExportDae | ExportFbx | ExportPreset | ExportNormals,
+};
+
+// "--" args from the command line, anything else is still input/outdir/m/preset
+struct ToolOptions {
+    bool profile = false;
+    std::string profileJsonPath; // empty = only print the report
+    bool trace = false;
+    std::string traceJsonPath; // empty = trace.json in the out folder
+    bool ioStats = false;
+    bool animImport = false;    // .dae/.fbx input is an animation to write as .mot
+    float tolLinear = 0.001f;   // max translate/scale error key reduction may add
+    float tolAngle = 0.1f;      // max rotation error per euler component, degrees
+    bool animBounds = false;    // .bin input gets bounds grown to fit its .mot clips
+    float boundsRate = 30.f;    // samples per second of clip for animBounds
+    uint32_t exportFormats = ExportDefault; // ExportFormat bits a .bin export writes
+    bool streamExport = false;  // .bin export reads and writes a node at a time instead of loading the whole model
+    bool keepStreams = false;   // .dae import writes every uv set as is instead of dropping unused/duplicate ones
+    float weightThreshold = 0.01f; // .dae import drops skin influences under this, 0 keeps them all
+    uint32_t maxInfluences = 0;    // .dae import keeps at most this many bones per vertex, 0 = no cap
+    bool keepMaterials = false;    // .dae import writes identical materials and unused textures as is
+    bool joinSubMeshes = false;    // .dae import joins a node's submeshes that end up on the same material
+};
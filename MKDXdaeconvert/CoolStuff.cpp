@@ -22,6 +22,12 @@
 // my headers
 #include "CoolStructs.h"
 #include "SaveFuncs.h"
+#include "AnimFuncs.h"
+#include "AnimBounds.h"
+#include "Profiler.h"
+#include "IOStats.h"
+#include "StreamDae.h"
+#include "ImportPasses.h"
 
 void FireLogoPrint(int x) {
     // if we detect regular cmd instead of terminal skip the logo stuff
@@ -73,25 +79,6 @@ void FireLogoPrint(int x) {
 
 }
 
-// helper funcs
-inline std::vector<int16_t> ReadUInt16s(std::istream& stream, size_t count) {
-    std::vector<int16_t> arr(count);
-    stream.read(reinterpret_cast<char*>(arr.data()), count * sizeof(uint16_t));
-    return arr;
-}
-
-inline std::vector<uint32_t> ReadUInt32s(std::istream& stream, size_t count) {
-    std::vector<uint32_t> arr(count);
-    stream.read(reinterpret_cast<char*>(arr.data()), count * sizeof(uint32_t));
-    return arr;
-}
-
-inline std::vector<float> ReadFloats(std::istream& stream, size_t count) {
-    std::vector<float> arr(count);
-    stream.read(reinterpret_cast<char*>(arr.data()), count * sizeof(float));
-    return arr;
-}
-
 void collectWorldVerts(aiNode* node, const aiScene* scene, const aiMatrix4x4& parentTransform, std::vector<aiVector3D>& vertsOut) {
     aiMatrix4x4 localTransform = parentTransform * node->mTransformation;
 
@@ -109,19 +96,6 @@ void collectWorldVerts(aiNode* node, const aiScene* scene, const aiMatrix4x4& pa
     }
 }
 
-std::string ReadCStringAtOffset(std::istream& stream, uint32_t pointer) {
-    auto currentPos = stream.tellg();
-    stream.seekg(pointer, std::ios::beg);
-
-    std::string result;
-    char c;
-    while (stream.get(c) && c != '\0')
-        result.push_back(c);
-
-    stream.seekg(currentPos, std::ios::beg);
-    return result;
-}
-
 static inline double clamp1(double v) {
     if (v < -1.0) return -1.0;
     if (v > 1.0) return  1.0;
@@ -349,334 +323,178 @@ void CallPatchDaePreAllFromDLL(const std::string& path)
     FreeLibrary(dll);
 }
 
-// all funcs to use the structs in coolstructs.h
-
-Header ReadHeader(std::istream& stream) {
-    char sig[4];
-    stream.read(sig, 4);
-    if (std::string(sig, 4) != "BIKE") {
-        std::ofstream(logPath.c_str(), std::ios::trunc) << "Invalid file signature. Expected 'BIKE'.";
-        throw std::runtime_error("Invalid file signature. Expected 'BIKE'.");
-    }
-
-    Header h;
-    h.Type = ReadUInt16s(stream, 1)[0];
-    h.Unknown = ReadUInt16s(stream, 1)[0];
-    h.Alignment = ReadUInt32s(stream, 1)[0];
-    h.Padding = ReadUInt32s(stream, 1)[0];
-    h.MaterialCount = ReadUInt32s(stream, 1)[0];
-    h.MaterialArrayOffset = ReadUInt32s(stream, 1)[0];
-    h.TextureMapsCount = ReadUInt32s(stream, 1)[0];
-    h.TextureNameArrayOffset = ReadUInt32s(stream, 1)[0];
-    h.BoneCount = ReadUInt32s(stream, 1)[0];
-    h.BoneNameArrayOffset = ReadUInt32s(stream, 1)[0];
-    h.RootNodeArrayOffset = ReadUInt32s(stream, 1)[0];
-    h.LinkNodeCount = ReadUInt32s(stream, 1)[0];
-    h.LinkNodeOffset = ReadUInt32s(stream, 1)[0];
-    h.TotalNodeCount = ReadUInt32s(stream, 1)[0];
-    h.TotalNodeArrayOffset = ReadUInt32s(stream, 1)[0];
-    h.Padding2 = ReadUInt32s(stream, 1)[0];
-    return h;
+bool dirExists(const std::string& path) {
+    struct stat info;
+    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
 }
 
-Material ReadMaterial(std::istream& stream) {
-    Material m;
-    m.Unknowns = ReadUInt32s(stream, 6);
-    m.UnknownValues = ReadUInt32s(stream, 4);
-    m.Diffuse = ReadFloats(stream, 4);
-    m.Specular = ReadFloats(stream, 4);
-    m.Ambience = ReadFloats(stream, 4);
-    float shiny;
-    stream.read(reinterpret_cast<char*>(&shiny), sizeof(float));
-    m.Shiny = shiny;
-    m.Unknowns2 = ReadFloats(stream, 19);
-
-    m.TextureIndices.resize(6);
-    for (int i = 0; i < 6; i++) {
-        int16_t val;
-        stream.read(reinterpret_cast<char*>(&val), sizeof(int16_t));
-        m.TextureIndices[i] = val;
-    }
-    return m;
+// full paths of the files in dir ending with ext
+std::vector<std::string> ListFilesWithExt(const std::string& dir, const std::string& ext) {
+    std::vector<std::string> files;
+    WIN32_FIND_DATAA ffd;
+    HANDLE hFind = FindFirstFileA((dir + "\\*" + ext).c_str(), &ffd);
+    if (hFind == INVALID_HANDLE_VALUE) return files;
+    do {
+        std::string fName = ffd.cFileName;
+        if (fName.size() >= ext.size() && fName.substr(fName.size() - ext.size()) == ext)
+            files.push_back(dir + "\\" + fName);
+    } while (FindNextFileA(hFind, &ffd) != 0);
+    FindClose(hFind);
+    return files;
 }
 
-BoneData ReadBoneData(std::istream& stream) {
-    BoneData b;
-    b.Visibility = ReadUInt32s(stream, 1)[0];
-    b.Scale = ReadFloats(stream, 3);
-    b.Rotation = ReadFloats(stream, 3);
-    b.Translation = ReadFloats(stream, 3);
-    b.BoundingBox = ReadFloats(stream, 4);
-    b.ModelObjectArrayOffset = ReadUInt32s(stream, 1)[0];
-    b.ChildrenArrayOffset = ReadUInt32s(stream, 1)[0];
-    b.MoreFloats = ReadFloats(stream, 3);
-	b.AnimationVals = ReadFloats(stream, 6);
-    b.BoundingBoxMaxMin = ReadFloats(stream, 6);
-    return b;
+std::string MakeAbsolutePath(const std::string& path)
+{
+#ifdef _WIN32
+    char absPath[_MAX_PATH];
+    if (_fullpath(absPath, path.c_str(), _MAX_PATH))
+        return std::string(absPath);
+    else
+        return path; // fallback if fail
+#else
+    char absPath[PATH_MAX];
+    if (realpath(path.c_str(), absPath))
+        return std::string(absPath);
+    else
+        return path; // fallback if fail
+#endif
 }
 
-SubMesh ReadSubMesh(std::istream& stream) {
-    SubMesh s;
-    s.Padding = ReadUInt32s(stream, 1)[0];
-    s.TriangleCount = ReadUInt32s(stream, 1)[0];
-    s.MaterialIndex = ReadUInt32s(stream, 1)[0];
-    s.BoundingBox = ReadFloats(stream, 4);
-    s.VertexCount = ReadUInt32s(stream, 1)[0];
-    s.VertexPositionOffset = ReadUInt32s(stream, 1)[0];
-    s.VertexNormalOffset = ReadUInt32s(stream, 1)[0];
-    s.ColorBufferOffset = ReadUInt32s(stream, 1)[0];
-    s.TexCoord0Offset = ReadUInt32s(stream, 1)[0];
-    s.TexCoord1Offset = ReadUInt32s(stream, 1)[0];
-    s.TexCoord2Offset = ReadUInt32s(stream, 1)[0];
-    s.TexCoord3Offset = ReadUInt32s(stream, 1)[0];
-    s.FaceOffset = ReadUInt32s(stream, 1)[0];
-    s.SkinnedBonesCount = ReadUInt32s(stream, 1)[0];
-    s.BonesIndexMask = ReadUInt32s(stream, 1)[0];
-    s.WeightOffset = ReadUInt32s(stream, 1)[0];
-    s.BoundingBoxMaxMin = ReadFloats(stream, 6);
-    return s;
+// number values of options, a value that isn't all number is reported and the option keeps its default
+static void ParseFloatValue(const std::string& name, const std::string& value, float& out) {
+    char* end = nullptr;
+    float parsed = strtof(value.c_str(), &end);
+    if (end == value.c_str() || *end != '\0') std::cerr << "Bad value for " << name << ": " << value << ", keeping " << out << "\n";
+    else out = parsed;
+}
+static void ParseUIntValue(const std::string& name, const std::string& value, uint32_t& out) {
+    char* end = nullptr;
+    unsigned long parsed = strtoul(value.c_str(), &end, 10);
+    if (end == value.c_str() || *end != '\0' || value[0] == '-' || parsed > UINT32_MAX) std::cerr << "Bad value for " << name << ": " << value << ", keeping " << out << "\n";
+    else out = static_cast<uint32_t>(parsed);
 }
 
-MKDXData LoadMKDXFile(std::ifstream& fs)
-{
-    MKDXData data;
-
-    auto headerData = ReadHeader(fs);
-    std::cout << "\nRead header: MaterialCount=" << headerData.MaterialCount << ", TextureMapsCount=" << headerData.TextureMapsCount << "\n";
-
-    fs.seekg(headerData.MaterialArrayOffset, std::ios::beg);
-    std::vector<Material> materialsData;
-    for (uint32_t i = 0; i < headerData.MaterialCount; ++i)
-        materialsData.push_back(ReadMaterial(fs));
-    std::cout << "Read materials: " << materialsData.size() << " materials added\n";
-
-    fs.seekg(headerData.TextureNameArrayOffset, std::ios::beg);
-    std::vector<TextureName> textureNames;
-    for (uint32_t i = 0; i < headerData.TextureMapsCount; ++i) {
-        uint32_t ptr;
-        fs.read(reinterpret_cast<char*>(&ptr), sizeof(ptr));
-        auto texName = ReadCStringAtOffset(fs, ptr);
-        textureNames.push_back(TextureName{ texName, ptr });
-        std::cout << "[" << i << "] " << texName << "\n";
+// "--name" or "--name=value", returns false if it's not one we know
+bool ParseToolOption(const std::string& arg, ToolOptions& options) {
+    size_t eq = arg.find('=');
+    std::string name = arg.substr(0, eq);
+    std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+    if (name == "--profile") {
+        options.profile = true;
+        options.profileJsonPath = value;
+        return true;
     }
-    std::cout << "Read texture names: " << textureNames.size() << " names added\n";
-
-    // seek to and read bone names
-    fs.seekg(headerData.BoneNameArrayOffset, std::ios::beg);
-    std::vector<NodeNames> boneNames;
-    for (uint32_t i = 0; i < headerData.BoneCount; ++i) {
-        uint32_t namePtr, dataOffset;
-        fs.read(reinterpret_cast<char*>(&namePtr), sizeof(namePtr));
-        fs.read(reinterpret_cast<char*>(&dataOffset), sizeof(dataOffset));
-        auto boneName = ReadCStringAtOffset(fs, namePtr);
-        boneNames.push_back(NodeNames{ dataOffset, boneName, namePtr });
+    if (name == "--trace") {
+        options.trace = true;
+        options.traceJsonPath = value;
+        return true;
     }
-
-    // read node links
-    fs.seekg(headerData.LinkNodeOffset, std::ios::beg);
-    std::vector<NodeLinks> nodeLinks;
-    for (uint32_t i = 0; i < headerData.LinkNodeCount; ++i) {
-        uint32_t meshOffset, boneOffset, dummy;
-        fs.read(reinterpret_cast<char*>(&meshOffset), sizeof(meshOffset));
-        fs.read(reinterpret_cast<char*>(&boneOffset), sizeof(boneOffset));
-        fs.read(reinterpret_cast<char*>(&dummy), sizeof(dummy)); // unused
-
-        auto it = std::find_if(nodeLinks.begin(), nodeLinks.end(), [meshOffset](const NodeLinks& n) { return n.MeshOffset == meshOffset; });
-        if (it == nodeLinks.end()) {
-            nodeLinks.push_back(NodeLinks{ meshOffset });
-            it = std::prev(nodeLinks.end());
-        }
-        it->BoneOffsets.push_back(boneOffset);
-
-        auto boneIt = std::find_if(boneNames.begin(), boneNames.end(), [boneOffset](const NodeNames& n) { return n.DataOffset == boneOffset; });
-        std::string boneName = (boneIt != boneNames.end()) ? boneIt->Name : "(unknown)";
-        //std::cout << "Linked meshOffset " << std::hex << meshOffset << " to boneOffset " << boneOffset << " (" << boneName << ")\n";
+    if (name == "--iostats") {
+        options.ioStats = true;
+        return true;
     }
-
-    // read all node names
-    fs.seekg(headerData.TotalNodeArrayOffset, std::ios::beg);
-    std::vector<NodeNames> allNodeNames;
-    for (uint32_t i = 0; i < headerData.TotalNodeCount; ++i) {
-        uint32_t namePtr, dataOffset;
-        fs.read(reinterpret_cast<char*>(&namePtr), sizeof(namePtr));
-        fs.read(reinterpret_cast<char*>(&dataOffset), sizeof(dataOffset));
-        auto name = ReadCStringAtOffset(fs, namePtr);
-        allNodeNames.push_back(NodeNames{ dataOffset, name, namePtr });
-        std::cout << "Added node: offset " << std::hex << dataOffset << " = \"" << name << "\"\n";
+    if (name == "--anim") {
+        options.animImport = true;
+        return true;
     }
-
-    // read root nodes (usually just 1)
-    fs.seekg(headerData.RootNodeArrayOffset, std::ios::beg);
-    std::vector<uint32_t> rootNodes;
-    while (true) {
-        uint32_t val;
-        fs.read(reinterpret_cast<char*>(&val), sizeof(val));
-        if (val == 0) break;
-        rootNodes.push_back(val);
-
-        auto nodeIt = std::find_if(allNodeNames.begin(), allNodeNames.end(), [val](const NodeNames& n) { return n.DataOffset == val; });
-        std::string name = (nodeIt != allNodeNames.end()) ? nodeIt->Name : "(unknown)";
-        std::cout << "Added root node offset: " << std::hex << val << " (" << name << ")\n";
+    if (name == "--tol-linear" && !value.empty()) {
+        ParseFloatValue(name, value, options.tolLinear);
+        return true;
     }
-
-    std::vector<FullNodeData> fullNodeDataList;
-
-    for (const auto& node : allNodeNames) {
-        fs.seekg(node.DataOffset, std::ios::beg);
-        BoneData boneData = ReadBoneData(fs);
-
-        uint32_t meshy = boneData.ModelObjectArrayOffset;
-        uint32_t childy = boneData.ChildrenArrayOffset;
-
-        FullNodeData fullData;
-        fullData.boneData = boneData;
-
-        if (meshy > 0) {
-            int j = 0;
-            while (true) {
-                fs.seekg(meshy + j * 4, std::ios::beg);
-                uint32_t submeshOffset;
-                fs.read(reinterpret_cast<char*>(&submeshOffset), sizeof(submeshOffset));
-                if (submeshOffset == 0) break;
-
-                fs.seekg(submeshOffset, std::ios::beg);
-                SubMesh submeshData = ReadSubMesh(fs);
-                fullData.subMeshes.push_back(submeshData);
-
-                uint32_t vCount = submeshData.VertexCount;
-                uint32_t pCount = submeshData.TriangleCount;
-                uint32_t wCount = submeshData.SkinnedBonesCount;
-
-                if (submeshData.VertexPositionOffset > 0) {
-                    fs.seekg(submeshData.VertexPositionOffset, std::ios::beg);
-                    std::vector<float> verts(vCount * 3);
-                    fs.read(reinterpret_cast<char*>(verts.data()), verts.size() * sizeof(float));
-                    fullData.verticesList.push_back(verts);
-                }
-                if (submeshData.VertexNormalOffset > 0) {
-                    fs.seekg(submeshData.VertexNormalOffset, std::ios::beg);
-                    std::vector<float> norms(vCount * 3);
-                    fs.read(reinterpret_cast<char*>(norms.data()), norms.size() * sizeof(float));
-                    fullData.normalsList.push_back(norms);
-                }
-                if (submeshData.ColorBufferOffset > 0) {
-                    fs.seekg(submeshData.ColorBufferOffset, std::ios::beg);
-                    std::vector<float> colors(vCount * 4);
-                    fs.read(reinterpret_cast<char*>(colors.data()), colors.size() * sizeof(float));
-                    fullData.colorsList.push_back(colors);
-                }
-                if (submeshData.TexCoord0Offset > 0) {
-                    fs.seekg(submeshData.TexCoord0Offset, std::ios::beg);
-                    std::vector<float> uvs0(vCount * 2);
-                    fs.read(reinterpret_cast<char*>(uvs0.data()), uvs0.size() * sizeof(float));
-                    fullData.uvs0List.push_back(uvs0);
-                }
-                if (submeshData.TexCoord1Offset > 0) {
-                    fs.seekg(submeshData.TexCoord1Offset, std::ios::beg);
-                    std::vector<float> uvs1(vCount * 2);
-                    fs.read(reinterpret_cast<char*>(uvs1.data()), uvs1.size() * sizeof(float));
-                    fullData.uvs1List.push_back(uvs1);
-                }
-                if (submeshData.TexCoord2Offset > 0) {
-                    fs.seekg(submeshData.TexCoord2Offset, std::ios::beg);
-                    std::vector<float> uvs2(vCount * 2);
-                    fs.read(reinterpret_cast<char*>(uvs2.data()), uvs2.size() * sizeof(float));
-                    fullData.uvs2List.push_back(uvs2);
-                }
-                if (submeshData.TexCoord3Offset > 0) {
-                    fs.seekg(submeshData.TexCoord3Offset, std::ios::beg);
-                    std::vector<float> uvs3(vCount * 2);
-                    fs.read(reinterpret_cast<char*>(uvs3.data()), uvs3.size() * sizeof(float));
-                    fullData.uvs3List.push_back(uvs3);
-                }
-                if (submeshData.FaceOffset > 0) {
-                    fs.seekg(submeshData.FaceOffset, std::ios::beg);
-                    std::vector<uint16_t> polys(pCount * 3);
-                    fs.read(reinterpret_cast<char*>(polys.data()), polys.size() * sizeof(uint16_t));
-                    fullData.polygonsList.push_back(polys);
-                }
-                if (submeshData.WeightOffset > 0) {
-                    fs.seekg(submeshData.WeightOffset, std::ios::beg);
-                    std::vector<float> weights(wCount * vCount);
-                    fs.read(reinterpret_cast<char*>(weights.data()), weights.size() * sizeof(float));
-                    fullData.weightsList.push_back(weights);
+    if (name == "--tol-angle" && !value.empty()) {
+        ParseFloatValue(name, value, options.tolAngle);
+        return true;
+    }
+    if (name == "--animbounds") {
+        options.animBounds = true;
+        return true;
+    }
+    if (name == "--rate" && !value.empty()) {
+        ParseFloatValue(name, value, options.boundsRate);
+        return true;
+    }
+    if (name == "--stream") {
+        options.streamExport = true;
+        return true;
+    }
+    if (name == "--keep-streams") {
+        options.keepStreams = true;
+        return true;
+    }
+    if (name == "--weight-threshold" && !value.empty()) {
+        ParseFloatValue(name, value, options.weightThreshold);
+        return true;
+    }
+    if (name == "--max-influences" && !value.empty()) {
+        ParseUIntValue(name, value, options.maxInfluences);
+        return true;
+    }
+    if (name == "--keep-materials") {
+        options.keepMaterials = true;
+        return true;
+    }
+    if (name == "--join-submeshes") {
+        options.joinSubMeshes = true;
+        return true;
+    }
+    if (name == "--formats" && !value.empty()) {
+        static const std::pair<const char*, uint32_t> formatNames[] = {
+            { "dae", ExportDae }, { "fbx", ExportFbx }, { "gltf", ExportGltf }, { "glb", ExportGlb },
+            { "preset", ExportPreset }, { "normals", ExportNormals }, { "default", ExportDefault } };
+        uint32_t formats = 0;
+        std::stringstream ss(value);
+        std::string format;
+        while (std::getline(ss, format, ',')) {
+            bool known = false;
+            for (const auto& f : formatNames) {
+                if (format == f.first) {
+                    formats |= f.second;
+                    known = true;
                 }
-                j++;
             }
+            if (!known) std::cerr << "Unknown format " << format << " in --formats, ignoring\n";
         }
-
-        if (childy > 0) {
-            fs.seekg(childy, std::ios::beg);
-            while (true) {
-                uint32_t childOffset;
-                fs.read(reinterpret_cast<char*>(&childOffset), sizeof(childOffset));
-                if (childOffset == 0) break;
-                fullData.childrenIndexList.push_back(childOffset);
-            }
-        }
-
-        fullNodeDataList.push_back(fullData);
-    }
-
-    for (auto& node : fullNodeDataList) {
-        for (size_t i = 0; i < node.childrenIndexList.size(); ++i)
-            node.childrenIndexList[i] = static_cast<uint32_t>(
-                std::find_if(allNodeNames.begin(), allNodeNames.end(),
-                    [&](const NodeNames& n) { return n.DataOffset == node.childrenIndexList[i]; }) - allNodeNames.begin());
+        if (formats) options.exportFormats = formats;
+        return true;
     }
+    return false;
+}
 
-    for (size_t i = 0; i < rootNodes.size(); ++i) {
-        rootNodes[i] = static_cast<uint32_t>(
-            std::find_if(allNodeNames.begin(), allNodeNames.end(),
-                [&](const NodeNames& n) { return n.DataOffset == rootNodes[i]; }) - allNodeNames.begin());
+// prints the profile report and writes the trace however main returns
+struct ProfileReportOnExit {
+    const ToolOptions& options;
+    ~ProfileReportOnExit() {
+        if (options.trace)
+            WriteTraceJson(options.traceJsonPath);
+        if (!options.profile) return;
+        PrintProfileReport();
+        if (!options.profileJsonPath.empty())
+            WriteProfileJson(options.profileJsonPath);
     }
+};
 
-    for (auto& link : nodeLinks) {
-        link.MeshOffset = static_cast<uint32_t>(
-            std::find_if(allNodeNames.begin(), allNodeNames.end(),
-                [&](const NodeNames& n) { return n.DataOffset == link.MeshOffset; }) - allNodeNames.begin());
-
-        for (size_t i = 0; i < link.BoneOffsets.size(); ++i) {
-            link.BoneOffsets[i] = static_cast<uint32_t>(
-                std::find_if(allNodeNames.begin(), allNodeNames.end(),
-                    [&](const NodeNames& n) { return n.DataOffset == link.BoneOffsets[i]; }) - allNodeNames.begin());
+// --animbounds for one .bin: samples the clips at motPaths (unreadable ones are skipped and counted in failedClips)
+// and writes the refitted model as _out.bin, false without writing anything if none of the clips could be read
+static bool FitBoundsToClips(const std::string& binPath, const std::string& outDir, MKDXData& data, const std::vector<std::string>& motPaths,
+    float rate, IOStats* ioStatsOut, AnimBoundsReport& report, size_t& failedClips)
+{
+    std::vector<MotData> clips;
+    for (const auto& motPath : motPaths) {
+        try {
+            clips.push_back(LoadMotFile(motPath));
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Skipping " << motPath << ": " << e.what() << "\n";
+            failedClips++;
         }
     }
+    if (clips.empty()) return false;
 
-    fs.close();
-
-    data.headerData = headerData;
-    data.materialsData = materialsData;
-    data.textureNames = textureNames;
-    data.nodeLinks = nodeLinks;
-    data.allNodeNames = allNodeNames;
-    data.rootNodes = rootNodes;
-    data.fullNodeDataList = fullNodeDataList;
-    data.boneNames = boneNames;
-
-    return data;
-}
-
-bool dirExists(const std::string& path) {
-    struct stat info;
-    return stat(path.c_str(), &info) == 0 && (info.st_mode & S_IFDIR);
-}
-
-std::string MakeAbsolutePath(const std::string& path)
-{
-#ifdef _WIN32
-    char absPath[_MAX_PATH];
-    if (_fullpath(absPath, path.c_str(), _MAX_PATH))
-        return std::string(absPath);
-    else
-        return path; // fallback if fail
-#else
-    char absPath[PATH_MAX];
-    if (realpath(path.c_str(), absPath))
-        return std::string(absPath);
-    else
-        return path; // fallback if fail
-#endif
+    UpdateAnimatedBounds(data, clips, rate, report);
+    SaveMKDXFile(binPath, outDir, data.headerData, data.materialsData, data.textureNames, data.boneNames,
+        data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList, ioStatsOut);
+    return true;
 }
 
 // define globals
@@ -707,6 +525,8 @@ int main(int argc, char* argv[])
     std::string outDir;
     std::string txtFilePath;
     bool mergeOn = false;
+    ToolOptions options;
+    std::vector<std::string> motArgs; // clips for --animbounds
 
     if (argc > 1) filePathInput = argv[1];
 
@@ -715,6 +535,16 @@ int main(int argc, char* argv[])
         if (strcmp(argv[i], "m") == 0) {
             mergeOn = true;
         }
+        else if (strncmp(argv[i], "--", 2) == 0) {
+            if (!ParseToolOption(argv[i], options))
+                std::cerr << "Unknown option " << argv[i] << ", ignoring\n";
+        }
+        else if (strlen(argv[i]) > 4 && strcmp(argv[i] + strlen(argv[i]) - 4, ".bin") == 0) {
+            // model to bind a .mot to, picked up in the .mot branch
+        }
+        else if (strlen(argv[i]) > 4 && strcmp(argv[i] + strlen(argv[i]) - 4, ".mot") == 0) {
+            motArgs.push_back(argv[i]);
+        }
         else {
             // if multiple outDirs passed, last one wins
             outDir = argv[i];
@@ -729,6 +559,18 @@ int main(int argc, char* argv[])
 
     outDir = MakeAbsolutePath(outDir);
 
+    if (options.trace && options.traceJsonPath.empty())
+        options.traceJsonPath = outDir + "\\trace.json";
+
+    EnableProfiling(options.profile);
+    EnableTracing(options.trace);
+    SetTraceThreadName("main");
+    ProfileReportOnExit profileReport{ options };
+    PROFILE_SCOPE("main");
+
+    IOStats ioStats;
+    IOStats* ioStatsOut = options.ioStats ? &ioStats : nullptr;
+
 	// debug default file path
     //if (filePathInput.empty()) filePathInput = "./KP_L_R_area3.bin";
     //if (filePathInput.empty()) filePathInput = "C:\\Users\\Blurro\\Downloads\\64646464.dae";
@@ -772,14 +614,97 @@ int main(int argc, char* argv[])
             // FIRE LOGO PRINT
             FireLogoPrint(56);
 
-            MKDXData data = LoadMKDXFile(fs);
+            if (options.animBounds) {
+                ProfileScope fileSpan("anim bounds", filePathInput.substr(filePathInput.find_last_of("/\\") + 1));
+                MKDXData data = LoadMKDXFile(fs, ioStatsOut);
+                if (ioStatsOut) PrintIOStats("LoadMKDXFile", ioStats);
+
+                // clips passed after the .bin, or every .mot next to it
+                if (motArgs.empty()) {
+                    size_t slash = filePathInput.find_last_of("/\\");
+                    motArgs = ListFilesWithExt(slash == std::string::npos ? "." : filePathInput.substr(0, slash), ".mot");
+                }
+                AnimBoundsReport report;
+                size_t failedClips = 0;
+                if (!FitBoundsToClips(filePathInput, outDir, data, motArgs, options.boundsRate, ioStatsOut, report, failedClips)) {
+                    std::cerr << "No .mot clips to sample, pass them after the .bin or put them next to it\n";
+                    std::ofstream(logPath.c_str(), std::ios::trunc) << "Error: no readable .mot files for " << filePathInput;
+                    return 1;
+                }
+                if (ioStatsOut) PrintIOStats("SaveMKDXFile", ioStats);
+
+                std::cout << std::dec << "\nSampled " << report.clips << " clip(s) at " << options.boundsRate << "/s, " << report.samples << " poses\n"
+                    << report.subMeshesGrown << " submesh and " << report.nodesGrown << " node bounds grown, largest radius increase " << report.maxRadiusGrowth << "\n";
+                std::ofstream(logPath.c_str(), std::ios::trunc) << "Saved " << MakeOutFilePath(filePathInput.substr(0, filePathInput.find_last_of('.')) + "_out.bin", outDir)
+                    << " with bounds fitted to " << report.clips << " animation(s)\n" << report.subMeshesGrown << " submesh and " << report.nodesGrown << " node bounds grown"
+                    << (failedClips == 0 ? "" : "\n" + std::to_string(failedClips) + " .mot file(s) couldn't be read");
+                return 0;
+            }
+
+            ProfileScope fileSpan("export bin", filePathInput.substr(filePathInput.find_last_of("/\\") + 1));
+            if (options.streamExport) {
+                MKDXData layout = LoadMKDXLayout(fs, ioStatsOut);
+                SaveDaeFileStreamed(filePathInput, outDir, fs, layout, mergeOn, options.exportFormats, ioStatsOut);
+                if (ioStatsOut) PrintIOStats("LoadMKDXLayout + streamed buffers", ioStats);
+                return 0;
+            }
+            MKDXData data = LoadMKDXFile(fs, ioStatsOut);
+            if (ioStatsOut) PrintIOStats("LoadMKDXFile", ioStats);
 
-            SaveDaeFile(filePathInput, outDir, data.headerData, data.materialsData, data.textureNames, data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList, mergeOn);
+            SaveDaeFile(filePathInput, outDir, data.headerData, data.materialsData, data.textureNames, data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList, mergeOn, options.exportFormats);
             //SaveMKDXFile(filePathInput, data.headerData, data.materialsData, data.textureNames, data.boneNames, data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList); // debug remake file
         }
 		else if (ext == ".mot")
 		{
-            std::ofstream(logPath.c_str(), std::ios::trunc) << "Animation file support coming in V1.9\nMessage @blurro on discord to hurry it up!";
+            // FIRE LOGO PRINT
+            FireLogoPrint(56);
+
+            std::string motName = filePathInput.substr(filePathInput.find_last_of("/\\") + 1);
+            ProfileScope fileSpan("load mot", motName);
+            MotData mot = LoadMotFile(filePathInput);
+            PrintMotSummary(motName, mot);
+
+            // model to bind to, a .bin arg or whichever .bin next to the clip shares the most bone names
+            std::string binPath;
+            for (int i = 2; i < argc; i++) {
+                std::string arg = argv[i];
+                if (arg.size() > 4 && arg.substr(arg.size() - 4) == ".bin") {
+                    binPath = arg;
+                    break;
+                }
+            }
+            if (binPath.empty()) {
+                size_t slash = filePathInput.find_last_of("/\\");
+                std::unordered_map<std::string, std::unordered_set<std::string>> nodeNameCache;
+                binPath = FindMotModel(mot, ListFilesWithExt(slash == std::string::npos ? "." : filePathInput.substr(0, slash), ".bin"), nodeNameCache);
+            }
+
+            MKDXData model;
+            bool haveModel = false;
+            if (!binPath.empty()) {
+                std::ifstream modelFs(binPath, std::ios::binary);
+                if (modelFs) {
+                    model = LoadMKDXFile(modelFs, ioStatsOut);
+                    haveModel = true;
+                    std::cout << std::dec << "\nBinding to skeleton of " << binPath << "\n";
+                }
+            }
+            if (!haveModel)
+                std::cout << "\nNo .bin with matching bone names found, exporting the clip's bones only\n";
+
+            SaveMotAnimation(filePathInput, outDir, mot, haveModel ? &model : nullptr);
+
+            std::ofstream(logPath.c_str(), std::ios::trunc) << "Saved animation " << motName << " (" << mot.headerData.BoneCount << " bones, "
+                << mot.keyTimes.size() << " keys) to " << outDir << " as .dae and .glb\n"
+                << (haveModel ? "Bound to skeleton of " + binPath : std::string("No matching .bin found, skeleton is the clip's bones only"));
+        }
+        else if ((ext == ".dae" || ext == ".fbx") && options.animImport)
+        {
+            // FIRE LOGO PRINT
+            FireLogoPrint(56);
+
+            ProfileScope importSpan("import anim", filePathInput.substr(filePathInput.find_last_of("/\\") + 1));
+            ImportMotAnimations(filePathInput, outDir, options.tolLinear, options.tolAngle);
         }
         else if (ext == ".dae" || ext == ".fbx")
         {
@@ -793,8 +718,10 @@ int main(int argc, char* argv[])
             // FIRE LOGO PRINT
             FireLogoPrint(56);
 
+            ProfileScope importSpan("import dae", filePathInput.substr(filePathInput.find_last_of("/\\") + 1));
             if (ext == ".fbx")
             {
+                PROFILE_SCOPE("FbxConverter");
                 struct stat buf;
                 std::string fbxPath = filePathInput;
 
@@ -823,6 +750,7 @@ int main(int argc, char* argv[])
                 }
             }
             else { // if dae file check if its a blender one
+                PROFILE_SCOPE("blender check");
                 std::ifstream in(filePathInput);
                 if (in) {
                     std::string line;
@@ -840,11 +768,17 @@ int main(int argc, char* argv[])
                 }
                 in.close();
             }
+            ProfileScope cloneStage("CloneAndFixFBXASC");
             filePathInput = CloneAndFixFBXASC(filePathInput, ext == ".fbx"); // doesnt clone dae if og file is fbx tho
+            cloneStage.End();
+            ProfileScope preAllStage("PatchDaePreAll");
             CallPatchDaePreAllFromDLL(filePathInput); // moves things from outside armature to inside armature
+            preAllStage.End();
 
             Assimp::Importer importer;
+            ProfileScope readStage("assimp read");
             const aiScene* scene = importer.ReadFile(filePathInput, aiProcess_Triangulate);
+            readStage.End();
 
             if (!scene || !scene->HasMeshes()) {
                 std::cerr << "failed to load scene or no meshes found\n";
@@ -924,6 +858,7 @@ int main(int argc, char* argv[])
             }
             else {
                 std::cout << "Using material preset file: " << presetPath << "\n";
+                ProfileScope presetStage("preset parse");
 
                 std::ifstream presetFile(presetPath);
                 if (!presetFile) {
@@ -1066,15 +1001,22 @@ int main(int argc, char* argv[])
                     return 1;
                 }
                 std::cout << "loaded " << materials.size() << " materials, " << textureNames.size() << " textures, and " << meshList.size() << " meshes" << "\n";
+                presetStage.End();
 
                 // func that splits meshes into submeshes based on bone counts per triangle
+                ProfileScope preImportStage("PatchDaePreImport");
                 CallPatchDaePreImportFromDLL(filePathInput, "final_groups.t");
+                preImportStage.End();
 
                 // modify dae.tmp file to treat non-listed child mesh nodes of a listed mesh node as being submeshes of that listed mesh
+                ProfileScope nodeToSubmeshStage("NodeToSubmesh");
                 CallNodeToSubmeshFromDLL(filePathInput, meshList);
+                nodeToSubmeshStage.End();
 
                 // reload scene
+                ProfileScope reloadStage("assimp reload");
                 scene = importer.ReadFile(filePathInput, aiProcess_Triangulate | aiProcess_JoinIdenticalVertices);
+                reloadStage.End();
 
                 // assign some header data
                 Header headerData;
@@ -1090,6 +1032,7 @@ int main(int argc, char* argv[])
 
                 aiNode* root = scene->mRootNode;
 
+                ProfileScope hierarchyStage("node hierarchy");
                 // always skip the first node (scene), then skip "Armature" if present
                 std::vector<aiNode*> nodesToProcess;
                 if (root) {
@@ -1189,6 +1132,9 @@ int main(int argc, char* argv[])
                 // debug print
                 //std::cout << "\nall nodes in order:\n"; for (const auto& node : allNodeNames) std::cout << "  " << node.Name << "\n";
 
+                hierarchyStage.End();
+
+                ProfileScope boneNamesStage("bone names");
                 // create allBoneNames vector with struct NodeNames, keeping DataOffset same as original nodes
                 std::vector<NodeNames> boneNames;
                 boneNames.reserve(nonMeshNodes.size());
@@ -1222,6 +1168,8 @@ int main(int argc, char* argv[])
                 headerData.BoneCount = static_cast<uint32_t>(nonMeshNodes.size());
                 headerData.TotalNodeCount = static_cast<uint32_t>(totalNodeCount);
 
+                boneNamesStage.End();
+
                 // turn material presets into materialsData list
                 std::vector<Material> materialsData;
                 materialsData.reserve(materials.size());
@@ -1258,7 +1206,9 @@ int main(int argc, char* argv[])
                 }
 
                 // fix material index on meshes (assimp loads in order of first used, not dae order)
+                ProfileScope materialIndicesStage("GetMaterialIndices");
                 auto meshMaterialMap = CallGetMaterialIndicesFromDLL(filePathInput);
+                materialIndicesStage.End();
                 for (unsigned int i = 0; i < scene->mNumMeshes; ++i) {
                     aiMesh* mesh = scene->mMeshes[i];
                     auto found = meshMaterialMap.find(mesh->mName.C_Str());
@@ -1269,7 +1219,9 @@ int main(int argc, char* argv[])
                 }
 
                 // loop in sorted order using the index indirection
+                ProfileScope nodesStage("build nodes");
                 for (size_t sortedIndex = 0; sortedIndex < sortedIndices.size(); ++sortedIndex) {
+                    ProfileScope submeshStage("submeshes");
                     size_t originalIndex = sortedIndices[sortedIndex];
                     aiNode* node = allAiNodes[originalIndex];
 
@@ -1296,6 +1248,7 @@ int main(int argc, char* argv[])
                         for (unsigned int meshIdx = 0; meshIdx < node->mNumMeshes; ++meshIdx) {
                             uint32_t meshIndex = node->mMeshes[meshIdx];
                             aiMesh* mesh = scene->mMeshes[meshIndex];
+                            PROFILE_SCOPE("GetDaeBoneNames");
                             auto daeBoneList = CallGetDaeBoneNamesFromDLL(filePathInput, mesh->mName.C_Str());
 
                             daeBoneListCombined.insert(daeBoneListCombined.end(), daeBoneList.begin(), daeBoneList.end());
@@ -1560,7 +1513,10 @@ int main(int argc, char* argv[])
                         }
                     }
 
+                    submeshStage.End();
+
                     // get global bounding box for this node
+                    PROFILE_SCOPE("node bounds");
                     std::vector<aiVector3D> allWorldVerts;
                     collectWorldVerts(node, scene, aiMatrix4x4(), allWorldVerts);
 
@@ -1615,13 +1571,50 @@ int main(int argc, char* argv[])
                     //for (auto b : uniqueBoneIndices) std::cout << b << " " << "\n";
                 }
 
+                nodesStage.End();
+
                 // set total links count in header
                 headerData.LinkNodeCount = totalLinksCount;
 
                 check.close();
 
+                if (!options.keepStreams) {
+                    StreamStripReport stripReport;
+                    StripUnusedStreams(fullNodeDataList, materialsData, stripReport);
+                    if (stripReport.bytesSaved)
+                        std::cout << std::dec << "\nDropped unused uv sets (uv0-3: " << stripReport.uvSetsDropped[0] << " " << stripReport.uvSetsDropped[1] << " "
+                            << stripReport.uvSetsDropped[2] << " " << stripReport.uvSetsDropped[3] << "), " << stripReport.bytesSaved / 1024 << " KB smaller\n";
+                }
+
+                if (options.weightThreshold > 0.f || options.maxInfluences) {
+                    WeightPruneReport pruneReport;
+                    PruneWeights(fullNodeDataList, nodeLinks, options.weightThreshold, options.maxInfluences, pruneReport);
+                    headerData.LinkNodeCount -= static_cast<uint32_t>(pruneReport.linksRemoved);
+                    if (pruneReport.influencesDropped) {
+                        std::cout << std::dec << "\nPruned " << pruneReport.influencesDropped << " skin influences, " << pruneReport.bytesSaved / 1024 << " KB smaller\n";
+                        for (const auto& sub : pruneReport.subMeshes)
+                            std::cout << "  " << allAiNodes[sub.node]->mName.C_Str() << " submesh " << sub.subMesh << ": "
+                                << sub.bonesBefore << " -> " << sub.bonesAfter << " bones\n";
+                        if (pruneReport.linksRemoved) std::cout << "  " << pruneReport.linksRemoved << " bone links no longer used\n";
+                    }
+                }
+
+                if (!options.keepMaterials || options.joinSubMeshes) {
+                    MaterialDedupReport dedupReport;
+                    if (!options.keepMaterials) {
+                        DedupMaterials(materialsData, textureNames, fullNodeDataList, dedupReport);
+                        headerData.MaterialCount = static_cast<uint32_t>(materialsData.size());
+                        headerData.TextureMapsCount = static_cast<uint32_t>(textureNames.size());
+                    }
+                    if (options.joinSubMeshes) MergeSameMaterialSubMeshes(fullNodeDataList, dedupReport);
+                    if (dedupReport.materialsMerged || dedupReport.texturesRemoved || dedupReport.subMeshesMerged)
+                        std::cout << std::dec << "\nMerged " << dedupReport.materialsMerged << " duplicate materials, dropped " << dedupReport.texturesRemoved
+                            << " unused textures, joined " << dedupReport.subMeshesMerged << " submeshes\n";
+                }
+
                 //std::cout << outDir << " is the output directory\n";
-                SaveMKDXFile(filePathInput, outDir, headerData, materialsData, textureNames, boneNames, nodeLinks, allNodeNames, rootNodes, fullNodeDataList);
+                SaveMKDXFile(filePathInput, outDir, headerData, materialsData, textureNames, boneNames, nodeLinks, allNodeNames, rootNodes, fullNodeDataList, ioStatsOut);
+                if (ioStatsOut) PrintIOStats("SaveMKDXFile", ioStats);
                 std::remove(filePathInput.c_str()); // remove tmp file
             }
         }
@@ -1652,6 +1645,32 @@ int main(int argc, char* argv[])
         {
             int converted = 0;
             int skipped = 0;
+            int motLoaded = 0;
+            size_t motKeys = 0;
+            int numMotFilesWithErrors = 0;
+            std::vector<std::string> folderBins = ListFilesWithExt(filePathInput, ".bin");
+            std::unordered_map<std::string, std::unordered_set<std::string>> nodeNameCache;
+            std::string loadedModelPath;
+            MKDXData loadedModel;
+
+            // --animbounds refits each .bin to the clips whose best model it is instead of exporting, the clips are
+            // only used for that so they aren't exported either
+            std::unordered_map<std::string, std::vector<std::string>> clipsByModel;
+            size_t failedBoundsClips = 0;
+            int boundsFitted = 0;
+            if (options.animBounds) {
+                ProfileScope matchStage("match clips to models");
+                for (const auto& motPath : ListFilesWithExt(filePathInput, ".mot")) {
+                    try {
+                        std::string modelPath = FindMotModel(LoadMotFile(motPath), folderBins, nodeNameCache);
+                        if (!modelPath.empty()) clipsByModel[modelPath].push_back(motPath);
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "Skipping " << motPath << ": " << e.what() << "\n";
+                        failedBoundsClips++;
+                    }
+                }
+            }
             do
             {
                 std::string fName = ffd.cFileName;
@@ -1660,13 +1679,34 @@ int main(int argc, char* argv[])
                     std::string fullPath = filePathInput + "\\" + fName;
                     if (fullPath.size() >= 4 && fullPath.substr(fullPath.size() - 4) == ".bin")
                     {
+                        ProfileScope fileSpan(options.animBounds ? "anim bounds" : "export bin", fName);
                         std::ifstream fs(fullPath, std::ios::binary);
                         if (fs) {
                             try {
-                                MKDXData data = LoadMKDXFile(fs);
-                                SaveDaeFile(fullPath, outDir, data.headerData, data.materialsData, data.textureNames,
-                                    data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList, mergeOn);
-                                converted++;
+                                if (options.animBounds) {
+                                    auto clipsIt = clipsByModel.find(fullPath);
+                                    MKDXData data;
+                                    AnimBoundsReport report;
+                                    if (clipsIt != clipsByModel.end()) data = LoadMKDXFile(fs, ioStatsOut);
+                                    if (clipsIt != clipsByModel.end() &&
+                                        FitBoundsToClips(fullPath, outDir, data, clipsIt->second, options.boundsRate, ioStatsOut, report, failedBoundsClips)) {
+                                        std::cout << std::dec << fName << ": " << report.clips << " clip(s), " << report.subMeshesGrown << " submesh and "
+                                            << report.nodesGrown << " node bounds grown\n";
+                                        boundsFitted++;
+                                    }
+                                    else skipped++;
+                                }
+                                else if (options.streamExport) {
+                                    MKDXData layout = LoadMKDXLayout(fs, ioStatsOut);
+                                    SaveDaeFileStreamed(fullPath, outDir, fs, layout, mergeOn, options.exportFormats, ioStatsOut);
+                                    converted++;
+                                }
+                                else {
+                                    MKDXData data = LoadMKDXFile(fs, ioStatsOut);
+                                    SaveDaeFile(fullPath, outDir, data.headerData, data.materialsData, data.textureNames,
+                                        data.nodeLinks, data.allNodeNames, data.rootNodes, data.fullNodeDataList, mergeOn, options.exportFormats);
+                                    converted++;
+                                }
                             }
                             catch (const std::exception& e) {
                                 numBinFilesWithErrors++;
@@ -1677,16 +1717,45 @@ int main(int argc, char* argv[])
                         }
                         else skipped++;
                     }
+                    else if (fullPath.size() >= 4 && fullPath.substr(fullPath.size() - 4) == ".mot")
+                    {
+                        if (options.animBounds) continue; // already sampled into their model's bounds
+                        ProfileScope fileSpan("export mot", fName);
+                        try {
+                            MotData mot = LoadMotFile(fullPath);
+                            PrintMotSummary(fName, mot);
+
+                            // clips of one character share a model, only reload it when the best match changes
+                            std::string modelPath = FindMotModel(mot, folderBins, nodeNameCache);
+                            if (!modelPath.empty() && modelPath != loadedModelPath) {
+                                std::ifstream modelFs(modelPath, std::ios::binary);
+                                loadedModel = LoadMKDXFile(modelFs);
+                                loadedModelPath = modelPath;
+                            }
+                            SaveMotAnimation(fullPath, outDir, mot, modelPath.empty() ? nullptr : &loadedModel);
+                            motLoaded++;
+                            motKeys += mot.keyTimes.size();
+                        }
+                        catch (...) {
+                            numMotFilesWithErrors++;
+                        }
+                    }
                     else skipped++;
                 }
             } while (FindNextFileA(hFind, &ffd) != 0);
             FindClose(hFind);
 
+            if (ioStatsOut) PrintIOStats("LoadMKDXFile (all files)", ioStats);
+
             std::ofstream(logPath.c_str(), std::ios::trunc)
                 << "Results: Exported contents of folder to " << outDir << "\n"
                 << converted << " file(s) converted\n"
                 << skipped << " file(s) skipped\n"
-                << numBinFilesWithErrors << " BIN file(s) with errors skipped";
+                << numBinFilesWithErrors << " BIN file(s) with errors skipped\n"
+                << motLoaded << " MOT file(s) exported (" << motKeys << " keys), " << numMotFilesWithErrors << " with errors";
+            if (options.animBounds)
+                std::ofstream(logPath.c_str(), std::ios::app) << "\n" << boundsFitted << " BIN file(s) saved with bounds fitted to their animations, "
+                    << failedBoundsClips << " MOT file(s) couldn't be read";
         }
     }
     else
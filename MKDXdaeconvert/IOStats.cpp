@@ -0,0 +1,37 @@
+#include <iostream>
+#include <cstdlib>
+#include <new>
+
+#include "IOStats.h"
+
+thread_local IOStats* activeIOStats = nullptr;
+
+// replaced global new so allocations made while a stats scope is active get counted
+// array/nothrow forms forward to these by default
+void* operator new(size_t size) {
+    if (activeIOStats) {
+        activeIOStats->allocations++;
+        activeIOStats->allocatedBytes += size;
+    }
+    if (size == 0) size = 1;
+    void* p = std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void PrintIOStats(const char* label, const IOStats& stats) {
+    std::cout << std::dec << "\n\033[34m--- " << label << " i/o ---\033[37m\n"
+        << "  seeks:       " << stats.seeks << "\n"
+        << "  reads:       " << stats.reads << " (" << stats.bytesRead << " bytes)\n"
+        << "  writes:      " << stats.writes << " (" << stats.bytesWritten << " bytes)\n"
+        << "  allocations: " << stats.allocations << " (" << stats.allocatedBytes << " bytes)\n"
+        << "  strings:     " << stats.stringsRead << "\n";
+}
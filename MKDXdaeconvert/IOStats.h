@@ -0,0 +1,62 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include <cstdint>
+
+// i/o counters for the BIKE reader and writer (--iostats)
+// counting only happens on threads inside an IOStatsScope, allocations are counted through global operator new
+struct IOStats {
+    uint64_t seeks = 0;
+    uint64_t reads = 0;
+    uint64_t writes = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t allocations = 0;
+    uint64_t allocatedBytes = 0;
+    uint64_t stringsRead = 0;
+};
+
+extern thread_local IOStats* activeIOStats;
+
+// points the counters at stats until the scope ends, nullptr stats = count nothing
+class IOStatsScope {
+public:
+    explicit IOStatsScope(IOStats* stats) : previous(activeIOStats) { activeIOStats = stats; }
+    ~IOStatsScope() { activeIOStats = previous; }
+
+    IOStatsScope(const IOStatsScope&) = delete;
+    IOStatsScope& operator=(const IOStatsScope&) = delete;
+
+private:
+    IOStats* previous;
+};
+
+void PrintIOStats(const char* label, const IOStats& stats);
+
+// counted stream helpers, use these instead of read/write/seek directly in the reader and writer
+inline void SeekReadPos(std::istream& stream, std::streamoff pos) {
+    if (activeIOStats) activeIOStats->seeks++;
+    stream.seekg(pos, std::ios::beg);
+}
+
+inline void SeekWritePos(std::ostream& stream, std::streamoff pos) {
+    if (activeIOStats) activeIOStats->seeks++;
+    stream.seekp(pos, std::ios::beg);
+}
+
+inline void ReadBytes(std::istream& stream, void* dst, size_t size) {
+    if (activeIOStats) {
+        activeIOStats->reads++;
+        activeIOStats->bytesRead += size;
+    }
+    stream.read(static_cast<char*>(dst), size);
+}
+
+inline void WriteBytes(std::ostream& stream, const void* src, size_t size) {
+    if (activeIOStats) {
+        activeIOStats->writes++;
+        activeIOStats->bytesWritten += size;
+    }
+    stream.write(static_cast<const char*>(src), size);
+}
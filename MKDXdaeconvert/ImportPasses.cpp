@@ -0,0 +1,364 @@
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+#include "ImportPasses.h"
+#include "ContentHash.h"
+#include "Profiler.h"
+
+static bool SamplesAnyTexture(const Material& material)
+{
+    for (int16_t texture : material.TextureIndices)
+        if (texture >= 0) return true;
+    return false;
+}
+
+// every vertex has the same uv, a constant set reads back as the same texel with or without it
+static bool IsConstantUv(const std::vector<float>& uvs)
+{
+    for (size_t i = 2; i + 1 < uvs.size(); i += 2)
+        if (memcmp(&uvs[i], &uvs[0], sizeof(float) * 2) != 0) return false;
+    return true;
+}
+
+void StripUnusedStreams(std::vector<FullNodeData>& fullNodeDataList, const std::vector<Material>& materialsData, StreamStripReport& report)
+{
+    PROFILE_SCOPE("StripUnusedStreams");
+    for (FullNodeData& node : fullNodeDataList) {
+        std::vector<std::vector<float>>* uvLists[4] = { &node.uvs0List, &node.uvs1List, &node.uvs2List, &node.uvs3List };
+
+        for (size_t s = 0; s < node.subMeshes.size(); ++s) {
+            SubMesh& sub = node.subMeshes[s];
+            uint32_t* uvOffsets[4] = { &sub.TexCoord0Offset, &sub.TexCoord1Offset, &sub.TexCoord2Offset, &sub.TexCoord3Offset };
+            bool sampled = sub.MaterialIndex >= materialsData.size() || SamplesAnyTexture(materialsData[sub.MaterialIndex]);
+
+            auto drop = [&](int set) {
+                std::vector<float>& uvs = (*uvLists[set])[s];
+                report.uvSetsDropped[set]++;
+                report.bytesSaved += uvs.size() * sizeof(float);
+                *uvOffsets[set] = 0;
+                std::vector<float>().swap(uvs); // entry stays so the lists still line up with subMeshes
+            };
+
+            for (int set = 0; set < 4; ++set) {
+                if (!*uvOffsets[set] || s >= uvLists[set]->size()) continue;
+                const std::vector<float>& uvs = (*uvLists[set])[s];
+
+                if (!sampled) {
+                    drop(set);
+                    continue;
+                }
+                if (set == 0) continue; // uv0 is what every texture reads
+
+                bool duplicate = IsConstantUv(uvs);
+                for (int lower = 0; lower < set && !duplicate; ++lower)
+                    duplicate = *uvOffsets[lower] && s < uvLists[lower]->size() && SameBuffer((*uvLists[lower])[s], uvs);
+                if (duplicate) drop(set);
+            }
+        }
+    }
+}
+
+// one submesh's dense bone-major weights (row per set mask bit, VertexCount each), returns the bits it still reads
+static uint32_t PruneSubMeshWeights(SubMesh& sub, std::vector<float>& weights, float threshold, uint32_t maxInfluences, WeightPruneReport& report)
+{
+    std::vector<uint32_t> bits;
+    for (uint32_t i = 0; i < 32; ++i)
+        if (sub.BonesIndexMask & (1u << i)) bits.push_back(i);
+    const size_t rows = bits.size(), vc = sub.VertexCount;
+    if (rows == 0 || weights.size() != rows * vc) return sub.BonesIndexMask; // not something this pass understands
+
+    std::vector<std::pair<float, size_t>> influences; // weight, row
+    std::vector<bool> rowUsed(rows, false);
+    for (size_t v = 0; v < vc; ++v) {
+        influences.clear();
+        for (size_t r = 0; r < rows; ++r)
+            if (weights[r * vc + v] > 0.f) influences.push_back({ weights[r * vc + v], r });
+        if (influences.empty()) continue;
+
+        std::sort(influences.begin(), influences.end(), [](const std::pair<float, size_t>& a, const std::pair<float, size_t>& b) { return a.first > b.first; });
+        size_t keep = influences.size();
+        if (maxInfluences && keep > maxInfluences) keep = maxInfluences;
+        while (keep > 1 && influences[keep - 1].first < threshold) --keep;
+
+        if (keep < influences.size()) {
+            float sum = 0.f;
+            for (size_t i = 0; i < keep; ++i) sum += influences[i].first;
+            for (size_t i = 0; i < influences.size(); ++i)
+                weights[influences[i].second * vc + v] = i < keep ? influences[i].first / sum : 0.f;
+            report.influencesDropped += influences.size() - keep;
+        }
+        for (size_t i = 0; i < keep; ++i) rowUsed[influences[i].second] = true;
+    }
+
+    // always leave a row so the submesh stays skinned, even if no vertex has weight at all
+    if (std::find(rowUsed.begin(), rowUsed.end(), true) == rowUsed.end()) rowUsed[0] = true;
+
+    size_t kept = 0;
+    for (size_t r = 0; r < rows; ++r) {
+        if (!rowUsed[r]) {
+            sub.BonesIndexMask &= ~(1u << bits[r]);
+            continue;
+        }
+        if (kept != r) std::copy(weights.begin() + r * vc, weights.begin() + (r + 1) * vc, weights.begin() + kept * vc);
+        ++kept;
+    }
+    if (kept < rows) {
+        report.bytesSaved += (rows - kept) * vc * sizeof(float);
+        weights.resize(kept * vc);
+        weights.shrink_to_fit();
+        sub.SkinnedBonesCount = static_cast<uint32_t>(kept);
+    }
+    return sub.BonesIndexMask;
+}
+
+void PruneWeights(std::vector<FullNodeData>& fullNodeDataList, std::vector<NodeLinks>& nodeLinks, float threshold,
+    uint32_t maxInfluences, WeightPruneReport& report)
+{
+    PROFILE_SCOPE("PruneWeights");
+    for (NodeLinks& link : nodeLinks) {
+        if (link.BoneOffsets.empty() || link.MeshOffset >= fullNodeDataList.size()) continue;
+        FullNodeData& node = fullNodeDataList[link.MeshOffset];
+
+        uint32_t readBefore = 0, readAfter = 0;
+        for (size_t s = 0; s < node.subMeshes.size(); ++s) {
+            SubMesh& sub = node.subMeshes[s];
+            readBefore |= sub.BonesIndexMask;
+            if (!sub.WeightOffset || !sub.SkinnedBonesCount || s >= node.weightsList.size()) {
+                readAfter |= sub.BonesIndexMask;
+                continue;
+            }
+
+            uint32_t before = sub.SkinnedBonesCount;
+            readAfter |= PruneSubMeshWeights(sub, node.weightsList[s], threshold, maxInfluences, report);
+            if (sub.SkinnedBonesCount != before)
+                report.subMeshes.push_back({ link.MeshOffset, s, before, sub.SkinnedBonesCount });
+        }
+
+        // only bones this pass emptied come out of the link, ones past the 6 bone cap that no mask ever read stay as they were
+        uint32_t emptied = readBefore & ~readAfter;
+        if (!emptied) continue;
+
+        std::vector<uint32_t> boneOffsets;
+        std::vector<uint32_t> newBit(link.BoneOffsets.size(), 0);
+        for (size_t i = 0; i < link.BoneOffsets.size(); ++i) {
+            if (i < 32 && (emptied & (1u << i))) continue;
+            newBit[i] = static_cast<uint32_t>(boneOffsets.size());
+            boneOffsets.push_back(link.BoneOffsets[i]);
+        }
+        for (SubMesh& sub : node.subMeshes) {
+            uint32_t mask = 0;
+            for (size_t i = 0; i < link.BoneOffsets.size() && i < 32; ++i)
+                if (sub.BonesIndexMask & (1u << i)) mask |= 1u << newBit[i];
+            sub.BonesIndexMask = mask;
+        }
+        report.linksRemoved += link.BoneOffsets.size() - boneOffsets.size();
+        link.BoneOffsets = std::move(boneOffsets);
+    }
+}
+
+static bool SameMaterial(const Material& a, const Material& b)
+{
+    return a.Unknowns == b.Unknowns && a.UnknownValues == b.UnknownValues && SameBuffer(a.Diffuse, b.Diffuse) &&
+        SameBuffer(a.Specular, b.Specular) && SameBuffer(a.Ambience, b.Ambience) && memcmp(&a.Shiny, &b.Shiny, sizeof(float)) == 0 &&
+        SameBuffer(a.Unknowns2, b.Unknowns2) && a.TextureIndices == b.TextureIndices;
+}
+
+void DedupMaterials(std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
+    std::vector<FullNodeData>& fullNodeDataList, MaterialDedupReport& report)
+{
+    PROFILE_SCOPE("DedupMaterials");
+    std::unordered_map<uint64_t, std::vector<uint32_t>> byHash; // hash of the fields -> kept material indices
+    std::vector<uint32_t> materialRemap(materialsData.size());
+    std::vector<Material> kept;
+    for (size_t i = 0; i < materialsData.size(); ++i) {
+        const Material& mat = materialsData[i];
+        uint64_t hash = HashBuffer(mat.Unknowns);
+        hash = HashBuffer(mat.UnknownValues, hash);
+        hash = HashBuffer(mat.Diffuse, hash);
+        hash = HashBuffer(mat.Specular, hash);
+        hash = HashBuffer(mat.Ambience, hash);
+        hash = HashBytes(&mat.Shiny, sizeof(float), hash);
+        hash = HashBuffer(mat.Unknowns2, hash);
+        hash = HashBuffer(mat.TextureIndices, hash);
+
+        std::vector<uint32_t>& candidates = byHash[hash];
+        auto same = std::find_if(candidates.begin(), candidates.end(), [&](uint32_t k) { return SameMaterial(kept[k], mat); });
+        if (same != candidates.end()) {
+            materialRemap[i] = *same;
+            report.materialsMerged++;
+            continue;
+        }
+        materialRemap[i] = static_cast<uint32_t>(kept.size());
+        candidates.push_back(materialRemap[i]);
+        kept.push_back(mat);
+    }
+
+    if (report.materialsMerged) {
+        materialsData = std::move(kept);
+        for (FullNodeData& node : fullNodeDataList)
+            for (SubMesh& sub : node.subMeshes)
+                if (sub.MaterialIndex < materialRemap.size()) sub.MaterialIndex = materialRemap[sub.MaterialIndex];
+    }
+
+    std::vector<int16_t> textureRemap(textureNames.size(), -1);
+    for (const Material& mat : materialsData)
+        for (int16_t texture : mat.TextureIndices)
+            if (texture >= 0 && static_cast<size_t>(texture) < textureNames.size()) textureRemap[texture] = 0;
+
+    std::vector<TextureName> usedTextures;
+    for (size_t t = 0; t < textureNames.size(); ++t) {
+        if (textureRemap[t] < 0) continue;
+        textureRemap[t] = static_cast<int16_t>(usedTextures.size());
+        usedTextures.push_back(std::move(textureNames[t]));
+    }
+    report.texturesRemoved = textureNames.size() - usedTextures.size();
+    if (!report.texturesRemoved) return;
+
+    textureNames = std::move(usedTextures);
+    for (Material& mat : materialsData)
+        for (int16_t& texture : mat.TextureIndices)
+            if (texture >= 0 && static_cast<size_t>(texture) < textureRemap.size()) texture = textureRemap[texture];
+}
+
+static uint32_t BitCount(uint32_t mask)
+{
+    uint32_t count = 0;
+    for (; mask; mask &= mask - 1) ++count;
+    return count;
+}
+
+// the mask bits of a submesh in order, each one has a VertexCount row in its weights
+static std::vector<uint32_t> MaskBits(uint32_t mask)
+{
+    std::vector<uint32_t> bits;
+    for (uint32_t i = 0; i < 32; ++i)
+        if (mask & (1u << i)) bits.push_back(i);
+    return bits;
+}
+
+// appends submesh b of node onto submesh a, caller has checked they can be joined
+static void AppendSubMesh(FullNodeData& node, size_t a, size_t b)
+{
+    SubMesh& dst = node.subMeshes[a];
+    const SubMesh& src = node.subMeshes[b];
+    const uint32_t vcA = dst.VertexCount, vcB = src.VertexCount;
+
+    std::vector<std::vector<float>>* lists[7] = { &node.verticesList, &node.normalsList, &node.colorsList,
+        &node.uvs0List, &node.uvs1List, &node.uvs2List, &node.uvs3List };
+    for (std::vector<std::vector<float>>* list : lists)
+        (*list)[a].insert((*list)[a].end(), (*list)[b].begin(), (*list)[b].end());
+
+    std::vector<uint16_t>& polys = node.polygonsList[a];
+    size_t firstNew = polys.size();
+    polys.insert(polys.end(), node.polygonsList[b].begin(), node.polygonsList[b].end());
+    for (size_t i = firstNew; i < polys.size(); ++i) polys[i] = static_cast<uint16_t>(polys[i] + vcA);
+
+    if (dst.WeightOffset) {
+        const uint32_t mask = dst.BonesIndexMask | src.BonesIndexMask;
+        const std::vector<uint32_t> bitsA = MaskBits(dst.BonesIndexMask), bitsB = MaskBits(src.BonesIndexMask);
+        const std::vector<float>& weightsA = node.weightsList[a];
+        const std::vector<float>& weightsB = node.weightsList[b];
+        std::vector<float> weights;
+        weights.reserve(BitCount(mask) * (vcA + vcB));
+        for (uint32_t bit : MaskBits(mask)) {
+            auto rowA = std::find(bitsA.begin(), bitsA.end(), bit);
+            auto rowB = std::find(bitsB.begin(), bitsB.end(), bit);
+            if (rowA != bitsA.end()) {
+                auto first = weightsA.begin() + (rowA - bitsA.begin()) * vcA;
+                weights.insert(weights.end(), first, first + vcA);
+            }
+            else weights.insert(weights.end(), vcA, 0.f);
+            if (rowB != bitsB.end()) {
+                auto first = weightsB.begin() + (rowB - bitsB.begin()) * vcB;
+                weights.insert(weights.end(), first, first + vcB);
+            }
+            else weights.insert(weights.end(), vcB, 0.f);
+        }
+        node.weightsList[a] = std::move(weights);
+        dst.BonesIndexMask = mask;
+        dst.SkinnedBonesCount = BitCount(mask);
+    }
+
+    // sphere around both spheres, box around both boxes
+    float centre[3], dist = 0.f;
+    for (int i = 0; i < 3; ++i) {
+        centre[i] = src.BoundingBox[i] - dst.BoundingBox[i];
+        dist += centre[i] * centre[i];
+    }
+    dist = std::sqrt(dist);
+    float rA = dst.BoundingBox[3], rB = src.BoundingBox[3];
+    if (dist + rB > rA) {
+        if (dist + rA <= rB) dst.BoundingBox = src.BoundingBox;
+        else {
+            float radius = (dist + rA + rB) * 0.5f;
+            for (int i = 0; i < 3; ++i) dst.BoundingBox[i] += centre[i] * ((radius - rA) / dist);
+            dst.BoundingBox[3] = radius;
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        dst.BoundingBoxMaxMin[i] = std::max(dst.BoundingBoxMaxMin[i], src.BoundingBoxMaxMin[i]);
+        dst.BoundingBoxMaxMin[i + 3] = std::min(dst.BoundingBoxMaxMin[i + 3], src.BoundingBoxMaxMin[i + 3]);
+    }
+
+    dst.VertexCount = vcA + vcB;
+    dst.TriangleCount += src.TriangleCount;
+}
+
+static bool CanJoinSubMeshes(const FullNodeData& node, size_t a, size_t b)
+{
+    const SubMesh& sa = node.subMeshes[a];
+    const SubMesh& sb = node.subMeshes[b];
+    if (sa.MaterialIndex != sb.MaterialIndex || static_cast<size_t>(sa.VertexCount) + sb.VertexCount > 0xFFFF) return false;
+
+    const uint32_t streamsA[7] = { sa.VertexNormalOffset, sa.ColorBufferOffset, sa.TexCoord0Offset, sa.TexCoord1Offset, sa.TexCoord2Offset, sa.TexCoord3Offset, sa.WeightOffset };
+    const uint32_t streamsB[7] = { sb.VertexNormalOffset, sb.ColorBufferOffset, sb.TexCoord0Offset, sb.TexCoord1Offset, sb.TexCoord2Offset, sb.TexCoord3Offset, sb.WeightOffset };
+    for (int i = 0; i < 7; ++i)
+        if (!streamsA[i] != !streamsB[i]) return false;
+
+    if (!sa.WeightOffset) return true;
+    // same 6 bone cap the import loop puts on SkinnedBonesCount, and weights have to be the dense size the mask says
+    return BitCount(sa.BonesIndexMask | sb.BonesIndexMask) <= 6 &&
+        node.weightsList[a].size() == BitCount(sa.BonesIndexMask) * size_t(sa.VertexCount) &&
+        node.weightsList[b].size() == BitCount(sb.BonesIndexMask) * size_t(sb.VertexCount);
+}
+
+void MergeSameMaterialSubMeshes(std::vector<FullNodeData>& fullNodeDataList, MaterialDedupReport& report)
+{
+    PROFILE_SCOPE("MergeSameMaterialSubMeshes");
+    for (FullNodeData& node : fullNodeDataList) {
+        const size_t count = node.subMeshes.size();
+        if (count < 2) continue;
+        std::vector<std::vector<float>>* lists[8] = { &node.verticesList, &node.normalsList, &node.colorsList,
+            &node.uvs0List, &node.uvs1List, &node.uvs2List, &node.uvs3List, &node.weightsList };
+        bool aligned = node.polygonsList.size() == count;
+        for (std::vector<std::vector<float>>* list : lists) aligned = aligned && list->size() == count;
+        if (!aligned) continue; // only the import's one entry per submesh layout
+
+        std::vector<bool> joined(count, false);
+        for (size_t a = 0; a < count; ++a) {
+            if (joined[a]) continue;
+            for (size_t b = a + 1; b < count; ++b) {
+                if (joined[b] || !CanJoinSubMeshes(node, a, b)) continue;
+                AppendSubMesh(node, a, b);
+                joined[b] = true;
+                report.subMeshesMerged++;
+            }
+        }
+
+        size_t kept = 0;
+        for (size_t s = 0; s < count; ++s) {
+            if (joined[s]) continue;
+            if (kept != s) {
+                node.subMeshes[kept] = std::move(node.subMeshes[s]);
+                for (std::vector<std::vector<float>>* list : lists) (*list)[kept] = std::move((*list)[s]);
+                node.polygonsList[kept] = std::move(node.polygonsList[s]);
+            }
+            ++kept;
+        }
+        node.subMeshes.resize(kept);
+        for (std::vector<std::vector<float>>* list : lists) list->resize(kept);
+        node.polygonsList.resize(kept);
+    }
+}
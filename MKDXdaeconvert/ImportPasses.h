@@ -0,0 +1,54 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "CoolStructs.h"
+
+struct StreamStripReport {
+    size_t uvSetsDropped[4] = {};  // per uv set
+    size_t bytesSaved = 0;
+};
+
+// run on the imported model before SaveMKDXFile, zeroes the offset (and frees the buffer) of every vertex stream that
+// can't change how a submesh renders so the writer leaves it out:
+// - uv sets when the submesh's material samples no texture at all (TextureIndices all -1)
+// - uv1-3 that are the same value on every vertex, or byte for byte a copy of a lower set that's kept
+// all white colours are already left out by the import loop, positions, normals, faces and weights are never touched
+void StripUnusedStreams(std::vector<FullNodeData>& fullNodeDataList, const std::vector<Material>& materialsData, StreamStripReport& report);
+
+struct WeightPruneReport {
+    struct SubMeshBones {
+        size_t node = 0;            // index into fullNodeDataList
+        size_t subMesh = 0;
+        uint32_t bonesBefore = 0;   // SkinnedBonesCount before/after
+        uint32_t bonesAfter = 0;
+    };
+    std::vector<SubMeshBones> subMeshes; // only submeshes that lost a bone
+    size_t influencesDropped = 0;
+    size_t linksRemoved = 0;        // bones no submesh of their node reads any more, taken out of NodeLinks
+    size_t bytesSaved = 0;
+};
+
+// run on the imported model before SaveMKDXFile, per vertex drops influences under threshold and keeps only the
+// maxInfluences biggest (0 = no cap), renormalising what's left to add up to 1, a vertex always keeps its biggest one
+// bones left with no weight on any vertex of a submesh lose their row and mask bit, and once no submesh of a node reads
+// one it's removed from the node's BoneOffsets with the mask bits after it shifted down
+void PruneWeights(std::vector<FullNodeData>& fullNodeDataList, std::vector<NodeLinks>& nodeLinks, float threshold,
+    uint32_t maxInfluences, WeightPruneReport& report);
+
+struct MaterialDedupReport {
+    size_t materialsMerged = 0;
+    size_t texturesRemoved = 0;
+    size_t subMeshesMerged = 0;
+};
+
+// run on the imported model before SaveMKDXFile, materials that match in every field become the first one of them and
+// every SubMesh::MaterialIndex is remapped, then texture names no material points at are dropped and TextureIndices
+// remapped, the header counts have to be set from the new sizes afterwards
+void DedupMaterials(std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
+    std::vector<FullNodeData>& fullNodeDataList, MaterialDedupReport& report);
+
+// joins submeshes of a node that use the same material into one, only when they have the same streams, the bones both
+// read fit in 6 and the vertices still fit in 16 bit indices, bounds become the ones covering both
+void MergeSameMaterialSubMeshes(std::vector<FullNodeData>& fullNodeDataList, MaterialDedupReport& report);
@@ -0,0 +1,406 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+// my headers
+#include "CoolStructs.h"
+#include "SaveFuncs.h"
+#include "Profiler.h"
+#include "IOStats.h"
+
+// helper funcs
+inline std::vector<int16_t> ReadUInt16s(std::istream& stream, size_t count) {
+    std::vector<int16_t> arr(count);
+    ReadBytes(stream, arr.data(), count * sizeof(uint16_t));
+    return arr;
+}
+
+inline std::vector<uint32_t> ReadUInt32s(std::istream& stream, size_t count) {
+    std::vector<uint32_t> arr(count);
+    ReadBytes(stream, arr.data(), count * sizeof(uint32_t));
+    return arr;
+}
+
+inline std::vector<float> ReadFloats(std::istream& stream, size_t count) {
+    std::vector<float> arr(count);
+    ReadBytes(stream, arr.data(), count * sizeof(float));
+    return arr;
+}
+
+std::string ReadCStringAtOffset(std::istream& stream, uint32_t pointer) {
+    auto currentPos = stream.tellg();
+    SeekReadPos(stream, pointer);
+
+    std::string result;
+    char c;
+    while (stream.get(c) && c != '\0')
+        result.push_back(c);
+
+    // one get() per char including the terminator
+    if (activeIOStats) {
+        activeIOStats->reads += result.size() + 1;
+        activeIOStats->bytesRead += result.size() + 1;
+        activeIOStats->stringsRead++;
+    }
+
+    SeekReadPos(stream, currentPos);
+    return result;
+}
+
+// all funcs to use the structs in coolstructs.h
+
+Header ReadHeader(std::istream& stream) {
+    char sig[4];
+    ReadBytes(stream, sig, 4);
+    if (std::string(sig, 4) != "BIKE") {
+        std::ofstream(logPath.c_str(), std::ios::trunc) << "Invalid file signature. Expected 'BIKE'.";
+        throw std::runtime_error("Invalid file signature. Expected 'BIKE'.");
+    }
+
+    Header h;
+    h.Type = ReadUInt16s(stream, 1)[0];
+    h.Unknown = ReadUInt16s(stream, 1)[0];
+    h.Alignment = ReadUInt32s(stream, 1)[0];
+    h.Padding = ReadUInt32s(stream, 1)[0];
+    h.MaterialCount = ReadUInt32s(stream, 1)[0];
+    h.MaterialArrayOffset = ReadUInt32s(stream, 1)[0];
+    h.TextureMapsCount = ReadUInt32s(stream, 1)[0];
+    h.TextureNameArrayOffset = ReadUInt32s(stream, 1)[0];
+    h.BoneCount = ReadUInt32s(stream, 1)[0];
+    h.BoneNameArrayOffset = ReadUInt32s(stream, 1)[0];
+    h.RootNodeArrayOffset = ReadUInt32s(stream, 1)[0];
+    h.LinkNodeCount = ReadUInt32s(stream, 1)[0];
+    h.LinkNodeOffset = ReadUInt32s(stream, 1)[0];
+    h.TotalNodeCount = ReadUInt32s(stream, 1)[0];
+    h.TotalNodeArrayOffset = ReadUInt32s(stream, 1)[0];
+    h.Padding2 = ReadUInt32s(stream, 1)[0];
+    return h;
+}
+
+Material ReadMaterial(std::istream& stream) {
+    Material m;
+    m.Unknowns = ReadUInt32s(stream, 6);
+    m.UnknownValues = ReadUInt32s(stream, 4);
+    m.Diffuse = ReadFloats(stream, 4);
+    m.Specular = ReadFloats(stream, 4);
+    m.Ambience = ReadFloats(stream, 4);
+    float shiny;
+    ReadBytes(stream, &shiny, sizeof(float));
+    m.Shiny = shiny;
+    m.Unknowns2 = ReadFloats(stream, 19);
+
+    m.TextureIndices.resize(6);
+    for (int i = 0; i < 6; i++) {
+        int16_t val;
+        ReadBytes(stream, &val, sizeof(int16_t));
+        m.TextureIndices[i] = val;
+    }
+    return m;
+}
+
+BoneData ReadBoneData(std::istream& stream) {
+    BoneData b;
+    b.Visibility = ReadUInt32s(stream, 1)[0];
+    b.Scale = ReadFloats(stream, 3);
+    b.Rotation = ReadFloats(stream, 3);
+    b.Translation = ReadFloats(stream, 3);
+    b.BoundingBox = ReadFloats(stream, 4);
+    b.ModelObjectArrayOffset = ReadUInt32s(stream, 1)[0];
+    b.ChildrenArrayOffset = ReadUInt32s(stream, 1)[0];
+    b.MoreFloats = ReadFloats(stream, 3);
+	b.AnimationVals = ReadFloats(stream, 6);
+    b.BoundingBoxMaxMin = ReadFloats(stream, 6);
+    return b;
+}
+
+SubMesh ReadSubMesh(std::istream& stream) {
+    SubMesh s;
+    s.Padding = ReadUInt32s(stream, 1)[0];
+    s.TriangleCount = ReadUInt32s(stream, 1)[0];
+    s.MaterialIndex = ReadUInt32s(stream, 1)[0];
+    s.BoundingBox = ReadFloats(stream, 4);
+    s.VertexCount = ReadUInt32s(stream, 1)[0];
+    s.VertexPositionOffset = ReadUInt32s(stream, 1)[0];
+    s.VertexNormalOffset = ReadUInt32s(stream, 1)[0];
+    s.ColorBufferOffset = ReadUInt32s(stream, 1)[0];
+    s.TexCoord0Offset = ReadUInt32s(stream, 1)[0];
+    s.TexCoord1Offset = ReadUInt32s(stream, 1)[0];
+    s.TexCoord2Offset = ReadUInt32s(stream, 1)[0];
+    s.TexCoord3Offset = ReadUInt32s(stream, 1)[0];
+    s.FaceOffset = ReadUInt32s(stream, 1)[0];
+    s.SkinnedBonesCount = ReadUInt32s(stream, 1)[0];
+    s.BonesIndexMask = ReadUInt32s(stream, 1)[0];
+    s.WeightOffset = ReadUInt32s(stream, 1)[0];
+    s.BoundingBoxMaxMin = ReadFloats(stream, 6);
+    return s;
+}
+
+MKDXData LoadMKDXLayout(std::istream& fs, IOStats* stats)
+{
+    PROFILE_SCOPE("LoadMKDXLayout");
+    IOStatsScope ioStatsScope(stats);
+    MKDXData data;
+
+    ProfileScope headerStage("header");
+    auto headerData = ReadHeader(fs);
+    headerStage.End();
+    std::cout << "\nRead header: MaterialCount=" << headerData.MaterialCount << ", TextureMapsCount=" << headerData.TextureMapsCount << "\n";
+
+    ProfileScope materialsStage("materials");
+    SeekReadPos(fs, headerData.MaterialArrayOffset);
+    std::vector<Material> materialsData;
+    for (uint32_t i = 0; i < headerData.MaterialCount; ++i)
+        materialsData.push_back(ReadMaterial(fs));
+    std::cout << "Read materials: " << materialsData.size() << " materials added\n";
+    materialsStage.End();
+
+    ProfileScope namesStage("names + links");
+    SeekReadPos(fs, headerData.TextureNameArrayOffset);
+    std::vector<TextureName> textureNames;
+    for (uint32_t i = 0; i < headerData.TextureMapsCount; ++i) {
+        uint32_t ptr;
+        ReadBytes(fs, &ptr, sizeof(ptr));
+        auto texName = ReadCStringAtOffset(fs, ptr);
+        textureNames.push_back(TextureName{ texName, ptr });
+        std::cout << "[" << i << "] " << texName << "\n";
+    }
+    std::cout << "Read texture names: " << textureNames.size() << " names added\n";
+
+    // seek to and read bone names
+    SeekReadPos(fs, headerData.BoneNameArrayOffset);
+    std::vector<NodeNames> boneNames;
+    for (uint32_t i = 0; i < headerData.BoneCount; ++i) {
+        uint32_t namePtr, dataOffset;
+        ReadBytes(fs, &namePtr, sizeof(namePtr));
+        ReadBytes(fs, &dataOffset, sizeof(dataOffset));
+        auto boneName = ReadCStringAtOffset(fs, namePtr);
+        boneNames.push_back(NodeNames{ dataOffset, boneName, namePtr });
+    }
+
+    // read node links
+    SeekReadPos(fs, headerData.LinkNodeOffset);
+    std::vector<NodeLinks> nodeLinks;
+    for (uint32_t i = 0; i < headerData.LinkNodeCount; ++i) {
+        uint32_t meshOffset, boneOffset, dummy;
+        ReadBytes(fs, &meshOffset, sizeof(meshOffset));
+        ReadBytes(fs, &boneOffset, sizeof(boneOffset));
+        ReadBytes(fs, &dummy, sizeof(dummy)); // unused
+
+        auto it = std::find_if(nodeLinks.begin(), nodeLinks.end(), [meshOffset](const NodeLinks& n) { return n.MeshOffset == meshOffset; });
+        if (it == nodeLinks.end()) {
+            nodeLinks.push_back(NodeLinks{ meshOffset });
+            it = std::prev(nodeLinks.end());
+        }
+        it->BoneOffsets.push_back(boneOffset);
+
+        auto boneIt = std::find_if(boneNames.begin(), boneNames.end(), [boneOffset](const NodeNames& n) { return n.DataOffset == boneOffset; });
+        std::string boneName = (boneIt != boneNames.end()) ? boneIt->Name : "(unknown)";
+        //std::cout << "Linked meshOffset " << std::hex << meshOffset << " to boneOffset " << boneOffset << " (" << boneName << ")\n";
+    }
+
+    // read all node names
+    SeekReadPos(fs, headerData.TotalNodeArrayOffset);
+    std::vector<NodeNames> allNodeNames;
+    for (uint32_t i = 0; i < headerData.TotalNodeCount; ++i) {
+        uint32_t namePtr, dataOffset;
+        ReadBytes(fs, &namePtr, sizeof(namePtr));
+        ReadBytes(fs, &dataOffset, sizeof(dataOffset));
+        auto name = ReadCStringAtOffset(fs, namePtr);
+        allNodeNames.push_back(NodeNames{ dataOffset, name, namePtr });
+        std::cout << "Added node: offset " << std::hex << dataOffset << " = \"" << name << "\"\n";
+    }
+
+    // read root nodes (usually just 1)
+    SeekReadPos(fs, headerData.RootNodeArrayOffset);
+    std::vector<uint32_t> rootNodes;
+    while (true) {
+        uint32_t val;
+        ReadBytes(fs, &val, sizeof(val));
+        if (val == 0) break;
+        rootNodes.push_back(val);
+
+        auto nodeIt = std::find_if(allNodeNames.begin(), allNodeNames.end(), [val](const NodeNames& n) { return n.DataOffset == val; });
+        std::string name = (nodeIt != allNodeNames.end()) ? nodeIt->Name : "(unknown)";
+        std::cout << "Added root node offset: " << std::hex << val << " (" << name << ")\n";
+    }
+
+    namesStage.End();
+
+    ProfileScope nodeDataStage("nodes");
+    std::vector<FullNodeData> fullNodeDataList;
+
+    for (const auto& node : allNodeNames) {
+        SeekReadPos(fs, node.DataOffset);
+        BoneData boneData = ReadBoneData(fs);
+
+        uint32_t meshy = boneData.ModelObjectArrayOffset;
+        uint32_t childy = boneData.ChildrenArrayOffset;
+
+        FullNodeData fullData;
+        fullData.boneData = boneData;
+
+        if (meshy > 0) {
+            int j = 0;
+            while (true) {
+                SeekReadPos(fs, meshy + j * 4);
+                uint32_t submeshOffset;
+                ReadBytes(fs, &submeshOffset, sizeof(submeshOffset));
+                if (submeshOffset == 0) break;
+
+                SeekReadPos(fs, submeshOffset);
+                fullData.subMeshes.push_back(ReadSubMesh(fs));
+                j++;
+            }
+        }
+
+        if (childy > 0) {
+            SeekReadPos(fs, childy);
+            while (true) {
+                uint32_t childOffset;
+                ReadBytes(fs, &childOffset, sizeof(childOffset));
+                if (childOffset == 0) break;
+                fullData.childrenIndexList.push_back(childOffset);
+            }
+        }
+
+        fullNodeDataList.push_back(std::move(fullData));
+    }
+    nodeDataStage.End();
+
+    // offsets to indices
+    ProfileScope remapStage("remap offsets");
+    for (auto& node : fullNodeDataList) {
+        for (size_t i = 0; i < node.childrenIndexList.size(); ++i)
+            node.childrenIndexList[i] = static_cast<uint32_t>(
+                std::find_if(allNodeNames.begin(), allNodeNames.end(),
+                    [&](const NodeNames& n) { return n.DataOffset == node.childrenIndexList[i]; }) - allNodeNames.begin());
+    }
+
+    for (size_t i = 0; i < rootNodes.size(); ++i) {
+        rootNodes[i] = static_cast<uint32_t>(
+            std::find_if(allNodeNames.begin(), allNodeNames.end(),
+                [&](const NodeNames& n) { return n.DataOffset == rootNodes[i]; }) - allNodeNames.begin());
+    }
+
+    for (auto& link : nodeLinks) {
+        link.MeshOffset = static_cast<uint32_t>(
+            std::find_if(allNodeNames.begin(), allNodeNames.end(),
+                [&](const NodeNames& n) { return n.DataOffset == link.MeshOffset; }) - allNodeNames.begin());
+
+        for (size_t i = 0; i < link.BoneOffsets.size(); ++i) {
+            link.BoneOffsets[i] = static_cast<uint32_t>(
+                std::find_if(allNodeNames.begin(), allNodeNames.end(),
+                    [&](const NodeNames& n) { return n.DataOffset == link.BoneOffsets[i]; }) - allNodeNames.begin());
+        }
+    }
+
+    remapStage.End();
+
+    data.headerData = headerData;
+    data.materialsData = std::move(materialsData);
+    data.textureNames = std::move(textureNames);
+    data.nodeLinks = std::move(nodeLinks);
+    data.allNodeNames = std::move(allNodeNames);
+    data.rootNodes = std::move(rootNodes);
+    data.fullNodeDataList = std::move(fullNodeDataList);
+    data.boneNames = std::move(boneNames);
+
+    return data;
+}
+
+// every buffer of a node's submeshes, lists only get an entry for submeshes that have that buffer (same as it always was)
+void LoadNodeBuffers(std::istream& fs, FullNodeData& fullData, bool weightsOnly)
+{
+    for (const SubMesh& submeshData : fullData.subMeshes) {
+        uint32_t vCount = submeshData.VertexCount;
+        uint32_t pCount = submeshData.TriangleCount;
+        uint32_t wCount = submeshData.SkinnedBonesCount;
+
+        if (submeshData.VertexPositionOffset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.VertexPositionOffset);
+            std::vector<float> verts(vCount * 3);
+            ReadBytes(fs, verts.data(), verts.size() * sizeof(float));
+            fullData.verticesList.push_back(std::move(verts));
+        }
+        if (submeshData.VertexNormalOffset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.VertexNormalOffset);
+            std::vector<float> norms(vCount * 3);
+            ReadBytes(fs, norms.data(), norms.size() * sizeof(float));
+            fullData.normalsList.push_back(std::move(norms));
+        }
+        if (submeshData.ColorBufferOffset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.ColorBufferOffset);
+            std::vector<float> colors(vCount * 4);
+            ReadBytes(fs, colors.data(), colors.size() * sizeof(float));
+            fullData.colorsList.push_back(std::move(colors));
+        }
+        if (submeshData.TexCoord0Offset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.TexCoord0Offset);
+            std::vector<float> uvs0(vCount * 2);
+            ReadBytes(fs, uvs0.data(), uvs0.size() * sizeof(float));
+            fullData.uvs0List.push_back(std::move(uvs0));
+        }
+        if (submeshData.TexCoord1Offset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.TexCoord1Offset);
+            std::vector<float> uvs1(vCount * 2);
+            ReadBytes(fs, uvs1.data(), uvs1.size() * sizeof(float));
+            fullData.uvs1List.push_back(std::move(uvs1));
+        }
+        if (submeshData.TexCoord2Offset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.TexCoord2Offset);
+            std::vector<float> uvs2(vCount * 2);
+            ReadBytes(fs, uvs2.data(), uvs2.size() * sizeof(float));
+            fullData.uvs2List.push_back(std::move(uvs2));
+        }
+        if (submeshData.TexCoord3Offset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.TexCoord3Offset);
+            std::vector<float> uvs3(vCount * 2);
+            ReadBytes(fs, uvs3.data(), uvs3.size() * sizeof(float));
+            fullData.uvs3List.push_back(std::move(uvs3));
+        }
+        if (submeshData.FaceOffset > 0 && !weightsOnly) {
+            SeekReadPos(fs, submeshData.FaceOffset);
+            std::vector<uint16_t> polys(pCount * 3);
+            ReadBytes(fs, polys.data(), polys.size() * sizeof(uint16_t));
+            fullData.polygonsList.push_back(std::move(polys));
+        }
+        if (submeshData.WeightOffset > 0) {
+            SeekReadPos(fs, submeshData.WeightOffset);
+            std::vector<float> weights(wCount * vCount);
+            ReadBytes(fs, weights.data(), weights.size() * sizeof(float));
+            fullData.weightsList.push_back(std::move(weights));
+        }
+    }
+}
+
+void FreeNodeBuffers(FullNodeData& fullData)
+{
+    // swapped out so the memory actually goes back, clear() would keep the capacity
+    std::vector<std::vector<float>>().swap(fullData.verticesList);
+    std::vector<std::vector<float>>().swap(fullData.normalsList);
+    std::vector<std::vector<float>>().swap(fullData.colorsList);
+    std::vector<std::vector<float>>().swap(fullData.uvs0List);
+    std::vector<std::vector<float>>().swap(fullData.uvs1List);
+    std::vector<std::vector<float>>().swap(fullData.uvs2List);
+    std::vector<std::vector<float>>().swap(fullData.uvs3List);
+    std::vector<std::vector<uint16_t>>().swap(fullData.polygonsList);
+    std::vector<std::vector<float>>().swap(fullData.weightsList);
+}
+
+MKDXData LoadMKDXFile(std::ifstream& fs, IOStats* stats)
+{
+    PROFILE_SCOPE("LoadMKDXFile");
+    MKDXData data = LoadMKDXLayout(fs, stats);
+
+    IOStatsScope ioStatsScope(stats);
+    ProfileScope buffersStage("node buffers");
+    for (auto& node : data.fullNodeDataList)
+        LoadNodeBuffers(fs, node);
+    buffersStage.End();
+
+    fs.close();
+    return data;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// read only view of a whole file, unmapped when it goes out of scope
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path);
+    void Close();
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
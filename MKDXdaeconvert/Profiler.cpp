@@ -0,0 +1,314 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+#include "Profiler.h"
+
+struct ProfileNode {
+    std::string name;
+    int parent = -1;
+    std::vector<int> children;
+    uint64_t calls = 0;
+    int64_t totalNs = 0;
+    uint64_t rssAtEnd = 0;      // largest working set seen when this stage finished
+    uint64_t peakGrowth = 0;    // largest amount this stage pushed the process peak up by
+    bool otherThread = false;   // ran on its own thread alongside the parent, so its time overlaps the parent's
+};
+
+struct TraceEvent {
+    std::string name;
+    std::string category;
+    int64_t startNs;
+    int64_t durationNs;
+    uint32_t threadId;
+};
+
+static bool profilingOn = false;
+static bool tracingOn = false;
+static std::mutex profileMutex;
+static std::vector<ProfileNode> profileNodes = { ProfileNode{ "total" } };
+static std::vector<TraceEvent> traceEvents;
+static std::vector<std::pair<uint32_t, std::string>> traceThreadNames;
+static thread_local int currentProfileNode = 0;
+static thread_local int threadBaseNode = -1;   // stage a ProfileThreadParent put this thread under
+static std::thread::id profileMainThread;
+static const auto profileEpoch = std::chrono::steady_clock::now();
+
+static int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+uint64_t GetCurrentRss() {
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.WorkingSetSize;
+}
+
+uint64_t GetPeakRss() {
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return 0;
+    return pmc.PeakWorkingSetSize;
+}
+
+int CurrentProfileStage() {
+    return currentProfileNode;
+}
+
+ProfileThreadParent::ProfileThreadParent(int stage)
+    : previousStage(currentProfileNode), previousBase(threadBaseNode) {
+    currentProfileNode = threadBaseNode = stage;
+}
+
+ProfileThreadParent::~ProfileThreadParent() {
+    currentProfileNode = previousStage;
+    threadBaseNode = previousBase;
+}
+
+void EnableProfiling(bool enabled) {
+    profilingOn = enabled;
+    profileMainThread = std::this_thread::get_id();
+}
+
+bool ProfilingEnabled() {
+    return profilingOn;
+}
+
+void EnableTracing(bool enabled) {
+    tracingOn = enabled;
+}
+
+bool TracingEnabled() {
+    return tracingOn;
+}
+
+void SetTraceThreadName(const std::string& name) {
+    if (!tracingOn) return;
+    uint32_t tid = GetCurrentThreadId();
+    std::lock_guard<std::mutex> lock(profileMutex);
+    for (auto& entry : traceThreadNames) {
+        if (entry.first == tid) {
+            entry.second = name;
+            return;
+        }
+    }
+    traceThreadNames.emplace_back(tid, name);
+}
+
+ProfileScope::ProfileScope(const char* name, const std::string& detail) {
+    if (!profilingOn && !tracingOn) return;
+
+    this->name = name;
+    this->detail = detail;
+    parentIndex = currentProfileNode;
+    // a thread nobody gave a parent to still shouldn't add to the main thread's total
+    bool otherThread = parentIndex == threadBaseNode || (parentIndex == 0 && std::this_thread::get_id() != profileMainThread);
+    {
+        std::lock_guard<std::mutex> lock(profileMutex);
+        for (int child : profileNodes[parentIndex].children) {
+            if (profileNodes[child].name == name && profileNodes[child].otherThread == otherThread) {
+                nodeIndex = child;
+                break;
+            }
+        }
+        if (nodeIndex < 0) {
+            nodeIndex = static_cast<int>(profileNodes.size());
+            ProfileNode node;
+            node.name = name;
+            node.parent = parentIndex;
+            node.otherThread = otherThread;
+            profileNodes.push_back(node);
+            profileNodes[parentIndex].children.push_back(nodeIndex);
+        }
+    }
+    currentProfileNode = nodeIndex;
+
+    startPeakRss = GetPeakRss();
+    startNs = NowNs();
+}
+
+ProfileScope::~ProfileScope() {
+    End();
+}
+
+void ProfileScope::End() {
+    if (nodeIndex < 0) return;
+
+    int64_t elapsed = NowNs() - startNs;
+    uint64_t rss = GetCurrentRss();
+    uint64_t peak = GetPeakRss();
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    ProfileNode& node = profileNodes[nodeIndex];
+    node.calls++;
+    node.totalNs += elapsed;
+    if (rss > node.rssAtEnd) node.rssAtEnd = rss;
+    if (peak > startPeakRss && peak - startPeakRss > node.peakGrowth) node.peakGrowth = peak - startPeakRss;
+
+    // trace viewer shows the name on the bar, so per-file spans get the file as the name and the stage as category
+    if (tracingOn) {
+        TraceEvent ev;
+        ev.name = detail.empty() ? name : detail;
+        ev.category = name;
+        ev.startNs = startNs;
+        ev.durationNs = elapsed;
+        ev.threadId = GetCurrentThreadId();
+        traceEvents.push_back(std::move(ev));
+    }
+
+    currentProfileNode = parentIndex;
+    nodeIndex = -1;
+}
+
+static double ToMs(int64_t ns) { return ns / 1000000.0; }
+static double ToMB(uint64_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+// root has no timer of its own, so it's the sum of the top level stages, ones from other threads overlap those
+static int64_t NodeTotalNs(int index) {
+    if (index != 0) return profileNodes[index].totalNs;
+    int64_t sum = 0;
+    for (int child : profileNodes[0].children)
+        if (!profileNodes[child].otherThread) sum += profileNodes[child].totalNs;
+    return sum;
+}
+
+static void PrintProfileNode(int index, int depth, int64_t parentNs) {
+    const ProfileNode& node = profileNodes[index];
+    int64_t total = NodeTotalNs(index);
+
+    std::string label = std::string(depth * 2, ' ') + node.name;
+    if (label.size() > (node.otherThread ? 40 : 44)) label = label.substr(0, node.otherThread ? 37 : 41) + "...";
+    if (node.otherThread) label += " [t]";
+
+    double percent = parentNs > 0 ? 100.0 * total / parentNs : 100.0;
+    std::cout << std::left << std::setw(45) << label << std::right
+        << std::setw(8) << (index == 0 ? 1 : node.calls)
+        << std::setw(13) << std::fixed << std::setprecision(2) << ToMs(total)
+        << std::setw(9) << std::setprecision(1) << percent
+        << std::setw(11) << std::setprecision(1) << ToMB(index == 0 ? GetCurrentRss() : node.rssAtEnd)
+        << std::setw(11) << std::setprecision(1) << ToMB(node.peakGrowth) << "\n";
+
+    for (int child : node.children)
+        PrintProfileNode(child, depth + 1, total);
+}
+
+void PrintProfileReport() {
+    if (!profilingOn) return;
+    std::lock_guard<std::mutex> lock(profileMutex);
+
+    std::cout << std::dec << "\n\033[34m--- profile ---\033[37m\n";
+    std::cout << std::left << std::setw(45) << "stage" << std::right
+        << std::setw(8) << "calls" << std::setw(13) << "total ms" << std::setw(9) << "%"
+        << std::setw(11) << "rss MB" << std::setw(11) << "+peak MB" << "\n";
+    PrintProfileNode(0, 0, 0);
+    std::cout << "[t] ran on its own thread alongside its parent, its time overlaps the parent's instead of adding to it\n";
+    std::cout << "process peak working set: " << std::fixed << std::setprecision(1) << ToMB(GetPeakRss()) << " MB\n";
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+static std::string JsonEscape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size() + 2);
+    for (char c : s) {
+        switch (c) {
+        case '"': out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            }
+            else out += c;
+        }
+    }
+    return out;
+}
+
+static void WriteProfileJsonNode(std::ostream& out, int index, int depth) {
+    const ProfileNode& node = profileNodes[index];
+    std::string pad(depth * 2, ' ');
+
+    out << pad << "{\"name\": \"" << JsonEscape(node.name) << "\", "
+        << "\"calls\": " << (index == 0 ? 1 : node.calls) << ", "
+        << "\"totalMs\": " << ToMs(NodeTotalNs(index)) << ", "
+        << "\"rssMB\": " << ToMB(index == 0 ? GetCurrentRss() : node.rssAtEnd) << ", "
+        << "\"peakGrowthMB\": " << ToMB(node.peakGrowth) << ", "
+        << "\"otherThread\": " << (node.otherThread ? "true" : "false") << ", "
+        << "\"children\": [";
+
+    if (!node.children.empty()) {
+        out << "\n";
+        for (size_t i = 0; i < node.children.size(); ++i) {
+            WriteProfileJsonNode(out, node.children[i], depth + 1);
+            if (i + 1 < node.children.size()) out << ",";
+            out << "\n";
+        }
+        out << pad;
+    }
+    out << "]}";
+}
+
+bool WriteProfileJson(const std::string& path) {
+    if (!profilingOn) return false;
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "failed to open " << path << " for profile json\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    out << std::fixed << std::setprecision(3);
+    out << "{\"peakRssMB\": " << ToMB(GetPeakRss()) << ",\n\"stages\":\n";
+    WriteProfileJsonNode(out, 0, 0);
+    out << "\n}\n";
+
+    std::cout << "Wrote profile json to " << path << "\n";
+    return true;
+}
+
+bool WriteTraceJson(const std::string& path) {
+    if (!tracingOn) return false;
+    std::ofstream out(path);
+    if (!out) {
+        std::cerr << "failed to open " << path << " for trace json\n";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(profileMutex);
+    uint32_t pid = GetCurrentProcessId();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\": \"ms\",\n\"traceEvents\": [\n";
+
+    bool first = true;
+    for (const auto& entry : traceThreadNames) {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid << ", \"tid\": " << entry.first
+            << ", \"args\": {\"name\": \"" << JsonEscape(entry.second) << "\"}}";
+    }
+
+    // timestamps are microseconds in the trace format
+    for (const auto& ev : traceEvents) {
+        if (!first) out << ",\n";
+        first = false;
+        out << "{\"name\": \"" << JsonEscape(ev.name) << "\", \"cat\": \"" << JsonEscape(ev.category) << "\", \"ph\": \"X\""
+            << ", \"ts\": " << ev.startNs / 1000.0 << ", \"dur\": " << ev.durationNs / 1000.0
+            << ", \"pid\": " << pid << ", \"tid\": " << ev.threadId << "}";
+    }
+    out << "\n]}\n";
+
+    std::cout << "Wrote trace json (" << traceEvents.size() << " events) to " << path << "\n";
+    return true;
+}
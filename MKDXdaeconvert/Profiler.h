@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+// scoped stage timers for --profile and --trace, does nothing unless one of them was enabled
+// scopes with the same name under the same parent get merged (calls counted), so they're fine inside loops
+// detail is only used by the trace (eg the file name for a per-file span)
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name, const std::string& detail = std::string());
+    ~ProfileScope();
+
+    // end the stage early, for stages that share a block with the next one
+    void End();
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    int nodeIndex = -1;
+    int parentIndex = -1;
+    int64_t startNs = 0;
+    uint64_t startPeakRss = 0;
+    const char* name = nullptr;
+    std::string detail;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+
+// scopes opened on a new thread would start at the top level and get their time counted again on top of the stage
+// that's waiting for the thread, take CurrentProfileStage() before starting it and put a ProfileThreadParent at the
+// top of the thread so its stages nest under that one, they're marked as run alongside it instead of inside it
+int CurrentProfileStage();
+
+class ProfileThreadParent {
+public:
+    explicit ProfileThreadParent(int stage);
+    ~ProfileThreadParent();
+
+    ProfileThreadParent(const ProfileThreadParent&) = delete;
+    ProfileThreadParent& operator=(const ProfileThreadParent&) = delete;
+
+private:
+    int previousStage;
+    int previousBase;
+};
+
+void EnableProfiling(bool enabled);
+bool ProfilingEnabled();
+void EnableTracing(bool enabled);
+bool TracingEnabled();
+
+// shows up as the thread's name in the trace viewer
+void SetTraceThreadName(const std::string& name);
+
+// hierarchical table to stdout, json is the same tree for diffing runs
+void PrintProfileReport();
+bool WriteProfileJson(const std::string& path);
+
+// chrome://tracing / perfetto trace event json, one complete event per scope
+bool WriteTraceJson(const std::string& path);
+
+// current and peak working set of this process in bytes
+uint64_t GetCurrentRss();
+uint64_t GetPeakRss();
@@ -13,10 +13,16 @@
 #include <assimp/postprocess.h>
 #include <vector>
 #include <regex>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <stdexcept>
 #include <assimp/DefaultLogger.hpp>
 #include <Windows.h>
 
 #include "SaveFuncs.h"
+#include "ContentHash.h"
+#include "Profiler.h"
 
 aiNode* BuildAiNode(uint32_t index, const std::vector<NodeNames>& allNodeNames,
     const std::vector<FullNodeData>& fullNodeDataList,
@@ -93,23 +99,126 @@ void CallPatchDaeFileDLL(const std::string& outFile, const std::vector<std::vect
     FreeLibrary(dll);
 }
 
-typedef void(__cdecl* GetNormalsFunc)(const char*);
-void CallGetNormalsFromDLL(const std::string& daePath) {
-    HMODULE dll = LoadLibraryA("tinyxml2patcher.dll");
-    if (!dll) {
-        std::cerr << "couldn't load tinyxml2patcher.dll\n";
+std::string GeometryNamer::Next(const std::string& name)
+{
+    // same steps as the rename loop in PatchDaeFile_C so the names come out identical
+    int count = nameCounts[name] + 1;
+    if (count <= 1) {
+        nameCounts[name] = 1;
+        return name;
+    }
+    std::string newName;
+    do {
+        newName = name + "_" + std::to_string(count);
+        count++;
+    } while (nameCounts.find(newName) != nameCounts.end());
+    nameCounts[newName] = 1;
+    nameCounts[name] = count - 1;
+    return newName;
+}
+
+// _normals.bin: "MKNR", uint32 version (1), uint32 mesh count, then per mesh uint32 name length, name, uint32 normal count, xyz floats
+NormalsSidecar::NormalsSidecar(const std::string& outBase)
+    : binPath(outBase + "_normals.bin"), scriptPath(outBase + "_normals.txt"), bin(binPath, std::ios::binary)
+{
+    if (!bin) {
+        std::cerr << "couldn't write " << binPath << "\n";
         return;
     }
+    const uint32_t version = 1;
+    bin.write("MKNR", 4);
+    bin.write(reinterpret_cast<const char*>(&version), sizeof(version));
+    meshCountPos = bin.tellp();
+    bin.write(reinterpret_cast<const char*>(&meshCount), sizeof(meshCount));
+}
 
-    GetNormalsFunc func = (GetNormalsFunc)GetProcAddress(dll, "GetDaeNormals_C");
-    if (!func) {
-        std::cerr << "couldn't find GetDaeNormals_C\n";
-        FreeLibrary(dll);
+NormalsSidecar::~NormalsSidecar()
+{
+    Finish();
+}
+
+void NormalsSidecar::AddMesh(const std::string& geometryName, const float* normals, uint32_t count)
+{
+    if (!bin.is_open() || !count) return;
+
+    // maya's shape name for the geometry, periods come through as FBXASC046
+    std::string name;
+    for (char c : geometryName) {
+        if (c == '.') name += "FBXASC046";
+        else name += c;
+    }
+    name += "Shape";
+
+    uint32_t nameLength = static_cast<uint32_t>(name.size());
+    bin.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+    bin.write(name.data(), nameLength);
+    bin.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    bin.write(reinterpret_cast<const char*>(normals), static_cast<std::streamsize>(count) * 3 * sizeof(float));
+    meshCount++;
+}
+
+void NormalsSidecar::Finish()
+{
+    if (!bin.is_open()) return;
+    bin.seekp(meshCountPos);
+    bin.write(reinterpret_cast<const char*>(&meshCount), sizeof(meshCount));
+    bin.close();
+
+    std::ofstream py(scriptPath);
+    if (!py) {
+        std::cerr << "couldn't write " << scriptPath << "\n";
         return;
     }
+    py << "import array\n";
+    py << "import struct\n";
+    py << "import maya.api.OpenMaya as om\n";
+    py << "import maya.cmds as cmds\n";
+    py << "import maya.utils\n\n";
+    py << "normalsPath = r\"" << binPath << "\"\n\n";
+    py << "def apply_normals():\n";
+    py << "    with open(normalsPath, 'rb') as f:\n";
+    py << "        data = f.read()\n";
+    py << "    magic, version, meshCount = struct.unpack_from('<4sII', data, 0)\n";
+    py << "    if magic != b'MKNR' or version != 1:\n";
+    py << "        print(f\"{normalsPath} isn't a normals file this script can read\")\n";
+    py << "        return\n";
+    py << "    offset = 12\n";
+    py << "    for _ in range(meshCount):\n";
+    py << "        nameLength, = struct.unpack_from('<I', data, offset)\n";
+    py << "        meshName = data[offset + 4:offset + 4 + nameLength].decode('utf-8', 'replace')\n";
+    py << "        offset += 4 + nameLength\n";
+    py << "        count, = struct.unpack_from('<I', data, offset)\n";
+    py << "        floats = array.array('f')\n";
+    py << "        floats.frombytes(data[offset + 4:offset + 4 + count * 12])\n";
+    py << "        offset += 4 + count * 12\n";
+    py << "        try:\n";
+    py << "            sel = om.MSelectionList()\n";
+    py << "            sel.add(meshName)\n";
+    py << "            fnMesh = om.MFnMesh(sel.getDagPath(0))\n";
+    py << "            it = iter(floats)\n";
+    py << "            normals = [om.MVector(x, y, z) for x, y, z in zip(it, it, it)]\n";
+    py << "            fnMesh.setVertexNormals(normals, list(range(count)))\n";
+    py << "            print(f\"done {meshName}\")\n";
+    py << "        except Exception as e:\n";
+    py << "            print(f\"error applying to {meshName}: {e}\")\n";
+    py << "    print('All normals applied!')\n";
+    py << "    for j in cmds.ls(type='joint'):\n";
+    py << "        if cmds.attributeQuery('radius', node=j, exists=True):\n";
+    py << "            cmds.setAttr(f\"{j}.radius\", 0.3)\n";
+    py << "\n";
+    py << "maya.utils.executeDeferred(apply_normals)\n";
+}
 
-    func(daePath.c_str());
-    FreeLibrary(dll);
+void WriteNormalsSidecar(const std::string& outBase, const aiScene* scene)
+{
+    NormalsSidecar sidecar(outBase);
+    GeometryNamer names;
+    for (unsigned int m = 0; m < scene->mNumMeshes; m++) {
+        const aiMesh* mesh = scene->mMeshes[m];
+        std::string name = names.Next(mesh->mName.C_Str());
+        // no normals in the scene mesh means the dae has none either (BuildExportScene drops mismatched counts)
+        if (mesh->mNormals) sidecar.AddMesh(name, &mesh->mNormals[0].x, mesh->mNumVertices);
+    }
 }
 
 void RenameNode(uint32_t root, uint32_t current, std::vector<NodeNames>& allNodeNames, const std::vector<FullNodeData>& fullNodeDataList)
@@ -314,10 +423,157 @@ std::string MakeOutFilePath(const std::string& path, const std::string& outDir)
     return fullPath;
 }
 
-void SaveDaeFile(const std::string& path, const std::string& outDir, Header& headerData, std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
+// convoluted preset name script lol
+std::string MakePresetPath(const std::string& path, const std::string& outDir, std::string& presetFilename)
+{
+    presetFilename = path.substr(path.find_last_of("/\\") + 1);
+    presetFilename = presetFilename.substr(0, presetFilename.find_last_of('.') == std::string::npos ? presetFilename.size() : presetFilename.find_last_of('.'));
+    presetFilename = presetFilename.substr(0, presetFilename.find_first_of(' ') == std::string::npos ? presetFilename.size() : presetFilename.find_first_of(' '));
+    std::string result;
+    bool capitalize = true;
+    for (char c : presetFilename) {
+        if (c == '_' || c == '-') { capitalize = true; continue; }
+        result += capitalize ? (char)toupper(c) : c;
+        capitalize = false;
+    }
+    if (result.size() >= 5 && result.substr(result.size() - 5) == "Model") result = result.substr(0, result.size() - 5);
+    return MakeOutFilePath(result + "_Preset.txt", outDir);
+}
+
+// convert to fbx thanks autodesk for coming in clutch
+static std::string FbxConverterPath()
+{
+    return exeDir + "\\fbxtool\\FbxConverter.exe";
+}
+
+bool HaveFbxConverter()
+{
+    struct stat buf;
+    return stat(FbxConverterPath().c_str(), &buf) == 0;
+}
+
+void RunFbxConverter(const std::string& daePath, const std::string& fbxPath)
+{
+    PROFILE_SCOPE("FbxConverter");
+    std::string cmd = "\"" + FbxConverterPath() + "\" \"" + daePath + "\" \"" + fbxPath + "\"";
+    cmd = "\"" + cmd + "\"";
+    //std::cout << "running command: " << cmd << std::endl;
+    system(cmd.c_str());
+}
+
+// all submeshes of a node as one aiMesh, every count is summed first so each attribute is allocated once at its final size
+// and filled straight from the flat .bin buffers, face indices get the submesh's vertex offset as they're copied
+static aiMesh* BuildMergedMesh(const FullNodeData& nodeData, const aiString& name,
+    std::vector<std::pair<unsigned int, std::vector<unsigned int>>>& materialToIndicesOrdered)
+{
+    size_t subCount = nodeData.subMeshes.size();
+    size_t vertexCount = 0, normalCount = 0, colorCount = 0, faceCount = 0;
+    bool hasUVs[4] = { false, false, false, false };
+    const std::vector<std::vector<float>>* uvLists[4] = { &nodeData.uvs0List, &nodeData.uvs1List, &nodeData.uvs2List, &nodeData.uvs3List };
+
+    // material order is first seen, same as the per face loop always built it
+    std::unordered_map<unsigned int, size_t> matIndexToOrder;
+    std::vector<size_t> materialIndexCounts;
+    for (size_t s = 0; s < subCount; s++) {
+        size_t verts = nodeData.verticesList[s].size() / 3;
+        size_t faces = nodeData.polygonsList[s].size() / 3;
+        vertexCount += verts;
+        faceCount += faces;
+        // no normals falls back to the positions, no colours to white
+        normalCount += nodeData.normalsList.size() > s ? nodeData.normalsList[s].size() / 3 : verts;
+        colorCount += nodeData.colorsList.size() > s ? nodeData.colorsList[s].size() / 4 : verts;
+        for (int uvIdx = 0; uvIdx < 4; uvIdx++)
+            hasUVs[uvIdx] |= uvLists[uvIdx]->size() > s && (*uvLists[uvIdx])[s].size() >= 2;
+
+        unsigned int matIndex = nodeData.subMeshes[s].MaterialIndex;
+        if (faces && !matIndexToOrder.count(matIndex)) {
+            matIndexToOrder[matIndex] = materialToIndicesOrdered.size();
+            materialToIndicesOrdered.emplace_back(matIndex, std::vector<unsigned int>());
+            materialIndexCounts.push_back(0);
+        }
+        if (faces) materialIndexCounts[matIndexToOrder[matIndex]] += faces * 3;
+    }
+    for (size_t i = 0; i < materialToIndicesOrdered.size(); i++)
+        materialToIndicesOrdered[i].second.reserve(materialIndexCounts[i]);
+
+    auto* mesh = new aiMesh();
+    mesh->mName = name; // keep original node name
+    mesh->mNumVertices = static_cast<unsigned int>(vertexCount);
+    mesh->mVertices = new aiVector3D[vertexCount];
+    if (vertexCount && normalCount == vertexCount) mesh->mNormals = new aiVector3D[vertexCount];
+    if (vertexCount && colorCount == vertexCount) mesh->mColors[0] = new aiColor4D[vertexCount];
+    for (int uvIdx = 0; uvIdx < 4; uvIdx++) {
+        if (!hasUVs[uvIdx]) continue;
+        mesh->mTextureCoords[uvIdx] = new aiVector3D[vertexCount]; // zeroed, submeshes without this set keep 0,0
+        mesh->mNumUVComponents[uvIdx] = 2;
+    }
+    mesh->mNumFaces = static_cast<unsigned int>(faceCount);
+    mesh->mFaces = new aiFace[faceCount];
+
+    unsigned int vertexOffset = 0;
+    size_t normalOffset = 0, colorOffset = 0, faceOffset = 0;
+    for (size_t s = 0; s < subCount; s++) {
+        const std::vector<float>& vertsFlat = nodeData.verticesList[s];
+        size_t verts = vertsFlat.size() / 3;
+        for (size_t v = 0; v < verts; v++)
+            mesh->mVertices[vertexOffset + v].Set(vertsFlat[v * 3], vertsFlat[v * 3 + 1], vertsFlat[v * 3 + 2]);
+
+        if (mesh->mNormals) {
+            const std::vector<float>& normsFlat = nodeData.normalsList.size() > s ? nodeData.normalsList[s] : vertsFlat;
+            size_t norms = normsFlat.size() / 3;
+            for (size_t v = 0; v < norms; v++)
+                mesh->mNormals[normalOffset + v].Set(normsFlat[v * 3], normsFlat[v * 3 + 1], normsFlat[v * 3 + 2]);
+            normalOffset += norms;
+        }
+
+        if (mesh->mColors[0]) {
+            if (nodeData.colorsList.size() > s) {
+                const std::vector<float>& colorsFlat = nodeData.colorsList[s];
+                size_t colors = colorsFlat.size() / 4;
+                for (size_t v = 0; v < colors; v++)
+                    mesh->mColors[0][colorOffset + v] = aiColor4D(colorsFlat[v * 4], colorsFlat[v * 4 + 1], colorsFlat[v * 4 + 2], colorsFlat[v * 4 + 3]);
+                colorOffset += colors;
+            }
+            else {
+                std::fill(mesh->mColors[0] + colorOffset, mesh->mColors[0] + colorOffset + verts, aiColor4D(1.0f, 1.0f, 1.0f, 1.0f));
+                colorOffset += verts;
+            }
+        }
+
+        for (int uvIdx = 0; uvIdx < 4; uvIdx++) {
+            if (!mesh->mTextureCoords[uvIdx] || uvLists[uvIdx]->size() <= s) continue;
+            const std::vector<float>& uvsFlat = (*uvLists[uvIdx])[s];
+            size_t uvs = (std::min)(uvsFlat.size() / 2, verts); // bracketed past the Windows.h min macro
+            for (size_t v = 0; v < uvs; v++)
+                mesh->mTextureCoords[uvIdx][vertexOffset + v].Set(uvsFlat[v * 2], uvsFlat[v * 2 + 1], 0.0f);
+        }
+
+        const auto& polys = nodeData.polygonsList[s];
+        size_t faces = polys.size() / 3;
+        std::vector<unsigned int>* materialIndices = faces ? &materialToIndicesOrdered[matIndexToOrder[nodeData.subMeshes[s].MaterialIndex]].second : nullptr;
+        for (size_t f = 0; f < faces; f++) {
+            aiFace& face = mesh->mFaces[faceOffset + f];
+            face.mNumIndices = 3;
+            face.mIndices = new unsigned int[3] {
+                static_cast<unsigned int>(polys[f * 3]) + vertexOffset,
+                    static_cast<unsigned int>(polys[f * 3 + 1]) + vertexOffset,
+                    static_cast<unsigned int>(polys[f * 3 + 2]) + vertexOffset
+                };
+            materialIndices->insert(materialIndices->end(), face.mIndices, face.mIndices + 3);
+        }
+        faceOffset += faces;
+        vertexOffset += static_cast<unsigned int>(verts);
+    }
+    return mesh;
+}
+
+aiScene* BuildExportScene(Header& headerData, std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
     std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
-    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes)
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes,
+    std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>>& allMaterialToIndices)
 {
+    PROFILE_SCOPE("build scene");
+    ProfileScope skeletonStage("skeleton + materials");
     // rename children of root to remove the root name prefix
     for (auto root : rootNodes) {
         // removed because not all files follow the same pattern, and not an issue in blender to have periods in names
@@ -383,10 +639,39 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
         scene->mMaterials[i]->AddProperty(ambientColor, 3, AI_MATKEY_COLOR_AMBIENT);
     }
 
-    // used for post processing dae patching to fix materials on a single mesh, assimp can only export 1 mat per mesh
-    std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>> allMaterialToIndices;
+    skeletonStage.End();
+
+    // unskinned geometry repeated on other nodes is exported once and instanced from each of them, nodes with bone
+    // links keep their own copy since the bones and their offset matrices are per mesh. Anything written per geometry
+    // (dae/gltf meshes, the normals sidecar) has to go by scene->mMeshes, walking nodes would repeat instanced ones
+    std::vector<uint8_t> hasLink(fullNodeDataList.size(), 0);
+    for (const auto& link : nodeLinks)
+        if (link.MeshOffset < hasLink.size()) hasLink[link.MeshOffset] = 1;
+
+    struct MeshSource {
+        uint32_t node;
+        size_t first, last; // submesh range the scene mesh was built from
+        unsigned int meshIndex;
+    };
+    std::unordered_map<uint64_t, std::vector<MeshSource>> meshesByContent;
+    size_t instancedMeshes = 0;
+    auto findInstance = [&](uint32_t node, size_t first, size_t last, uint64_t& contentHash) -> int {
+        contentHash = ContentHashSeed;
+        for (size_t s = first; s < last; s++) contentHash = HashSubMeshContent(fullNodeDataList[node], s, contentHash);
+        auto it = meshesByContent.find(contentHash);
+        if (it == meshesByContent.end()) return -1;
+        for (const MeshSource& source : it->second) {
+            if (source.last - source.first != last - first) continue;
+            bool same = true;
+            for (size_t s = 0; same && s < last - first; s++)
+                same = SameSubMeshContent(fullNodeDataList[source.node], source.first + s, fullNodeDataList[node], first + s);
+            if (same) return static_cast<int>(source.meshIndex);
+        }
+        return -1;
+    };
 
     // big loop that merges submeshes
+    ProfileScope meshStage(mergeSubmeshes ? "meshes (merged)" : "meshes");
     for (size_t nodeIndex = 0; nodeIndex < fullNodeDataList.size(); nodeIndex++) {
         const auto& nodeData = fullNodeDataList[nodeIndex];
         // set up transforms
@@ -432,133 +717,23 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
 
         if (mergeSubmeshes)
         {
-            std::vector<aiVector3D> mergedVerts;
-            std::vector<aiVector3D> mergedNorms;
-            std::vector<aiColor4D> mergedColors;
-            std::vector<aiVector3D> mergedUVs[4];
-            std::vector<aiFace> mergedFaces;
-
-            unsigned int vertexOffset = 0;
+            uint64_t contentHash = 0;
+            int instanceOf = hasLink[nodeIndex] ? -1 : findInstance(static_cast<uint32_t>(nodeIndex), 0, nodeData.subMeshes.size(), contentHash);
+            if (instanceOf >= 0) {
+                delete[] parentNode->mMeshes;
+                parentNode->mNumMeshes = 1;
+                parentNode->mMeshes = new unsigned int[1] { static_cast<unsigned int>(instanceOf) };
+                instancedMeshes++;
+                continue;
+            }
 
             // used for post processing dae patching to fix materials on a single mesh (this var is per mesh, and is to be added to the 'all' var containing data for all meshes)
             std::vector<std::pair<unsigned int, std::vector<unsigned int>>> materialToIndicesOrdered;
-            std::unordered_map<unsigned int, size_t> matIndexToOrder;
-
-            for (size_t s = 0; s < nodeData.subMeshes.size(); s++) {
-                std::vector<float> vertsFlat = nodeData.verticesList[s];
-                std::vector<aiVector3D> verts;
-                for (size_t i = 0; i + 2 < vertsFlat.size(); i += 3)
-                    verts.emplace_back(vertsFlat[i], vertsFlat[i + 1], vertsFlat[i + 2]);
-
-                std::vector<aiVector3D> norms;
-                if (nodeData.normalsList.size() > s) {
-                    const auto& normsFlat = nodeData.normalsList[s];
-                    for (size_t i = 0; i + 2 < normsFlat.size(); i += 3)
-                        norms.emplace_back(normsFlat[i], normsFlat[i + 1], normsFlat[i + 2]);
-                }
-                else {
-                    norms = verts;
-                }
-
-                std::vector<aiColor4D> colors;
-                if (nodeData.colorsList.size() > s) {
-                    const auto& colorsFlat = nodeData.colorsList[s];
-                    for (size_t i = 0; i + 3 < colorsFlat.size(); i += 4)
-                        colors.emplace_back(colorsFlat[i], colorsFlat[i + 1], colorsFlat[i + 2], colorsFlat[i + 3]);
-                }
-                else {
-                    colors.resize(verts.size(), aiColor4D(1.0f, 1.0f, 1.0f, 1.0f)); // default to white
-                }
+            aiMesh* mergedMesh = BuildMergedMesh(nodeData, parentNode->mName, materialToIndicesOrdered);
 
-                std::vector<aiVector3D> uvs[4];
-                const std::vector<float>* uvsLists[4] = {
-                    (nodeData.uvs0List.size() > s) ? &nodeData.uvs0List[s] : nullptr,
-                    (nodeData.uvs1List.size() > s) ? &nodeData.uvs1List[s] : nullptr,
-                    (nodeData.uvs2List.size() > s) ? &nodeData.uvs2List[s] : nullptr,
-                    (nodeData.uvs3List.size() > s) ? &nodeData.uvs3List[s] : nullptr
-                };
-                for (int uvIdx = 0; uvIdx < 4; uvIdx++) {
-                    if (uvsLists[uvIdx]) {
-                        const auto& uvsFlat = *uvsLists[uvIdx];
-                        for (size_t i = 0; i + 1 < uvsFlat.size(); i += 2)
-                            uvs[uvIdx].emplace_back(uvsFlat[i], uvsFlat[i + 1], 0.0f);
-                    }
-                }
-
-                // add verts, norms, uvs
-                mergedVerts.insert(mergedVerts.end(), verts.begin(), verts.end());
-
-                // remap indices for this submesh
-                std::vector<unsigned int> remappedIndices;
-                remappedIndices.reserve(verts.size());
-                for (size_t i = 0; i < verts.size(); ++i)
-                    remappedIndices.push_back(vertexOffset + static_cast<unsigned int>(i));
-
-                mergedNorms.insert(mergedNorms.end(), norms.begin(), norms.end());
-                mergedColors.insert(mergedColors.end(), colors.begin(), colors.end());
-                for (int uvIdx = 0; uvIdx < 4; uvIdx++)
-                    mergedUVs[uvIdx].insert(mergedUVs[uvIdx].end(), uvs[uvIdx].begin(), uvs[uvIdx].end());
-
-                // adjust indices and add faces
-                for (size_t i = 0; i + 2 < nodeData.polygonsList[s].size(); i += 3) {
-                    aiFace face;
-                    face.mNumIndices = 3;
-                    face.mIndices = new unsigned int[3] {
-                        static_cast<unsigned int>(nodeData.polygonsList[s][i]) + vertexOffset,
-                            static_cast<unsigned int>(nodeData.polygonsList[s][i + 1]) + vertexOffset,
-                            static_cast<unsigned int>(nodeData.polygonsList[s][i + 2]) + vertexOffset
-                        };
-                    mergedFaces.push_back(face);
-
-                    // store in materialToIndices map for later dae post processing
-                    unsigned int matIndex = nodeData.subMeshes[s].MaterialIndex;
-                    if (!matIndexToOrder.count(matIndex)) {
-                        matIndexToOrder[matIndex] = materialToIndicesOrdered.size();
-                        materialToIndicesOrdered.emplace_back(matIndex, std::vector<unsigned int>());
-                    }
-                    auto& indicesVec = materialToIndicesOrdered[matIndexToOrder[matIndex]].second;
-                    indicesVec.push_back(face.mIndices[0]);
-                    indicesVec.push_back(face.mIndices[1]);
-                    indicesVec.push_back(face.mIndices[2]);
-                }
-
-                vertexOffset += static_cast<unsigned int>(verts.size());
-            }
             // store material to indices mapping for this mesh
             allMaterialToIndices.push_back(std::move(materialToIndicesOrdered));
 
-            // create merged mesh
-            auto* mergedMesh = new aiMesh();
-            mergedMesh->mName = aiString(std::string(parentNode->mName.C_Str())); // keep original node name
-            mergedMesh->mNumVertices = static_cast<unsigned int>(mergedVerts.size());
-            mergedMesh->mVertices = new aiVector3D[mergedVerts.size()];
-            std::copy(mergedVerts.begin(), mergedVerts.end(), mergedMesh->mVertices);
-
-            // apply normals
-            if (!mergedNorms.empty() && mergedNorms.size() == mergedMesh->mNumVertices) {
-                mergedMesh->mNormals = new aiVector3D[mergedNorms.size()];
-                std::copy(mergedNorms.begin(), mergedNorms.end(), mergedMesh->mNormals);
-            }
-
-            // apply vertex colors
-            if (!mergedColors.empty() && mergedColors.size() == mergedMesh->mNumVertices) {
-                mergedMesh->mColors[0] = new aiColor4D[mergedColors.size()];
-                std::copy(mergedColors.begin(), mergedColors.end(), mergedMesh->mColors[0]);
-            }
-
-            // apply uvs
-            for (int uvIdx = 0; uvIdx < 4; uvIdx++) {
-                if (!mergedUVs[uvIdx].empty()) {
-                    mergedMesh->mTextureCoords[uvIdx] = new aiVector3D[mergedUVs[uvIdx].size()];
-                    std::copy(mergedUVs[uvIdx].begin(), mergedUVs[uvIdx].end(), mergedMesh->mTextureCoords[uvIdx]);
-                    mergedMesh->mNumUVComponents[uvIdx] = 2;
-                }
-            }
-
-            mergedMesh->mNumFaces = static_cast<unsigned int>(mergedFaces.size());
-            mergedMesh->mFaces = new aiFace[mergedFaces.size()];
-            std::copy(mergedFaces.begin(), mergedFaces.end(), mergedMesh->mFaces);
-
             mergedMesh->mMaterialIndex = nodeData.subMeshes[0].MaterialIndex;
 
             // add merged mesh to scene
@@ -570,6 +745,8 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
             scene->mMeshes = newMeshes;
             unsigned int mergedMeshIndex = scene->mNumMeshes;
             scene->mNumMeshes++;
+            if (!hasLink[nodeIndex])
+                meshesByContent[contentHash].push_back({ static_cast<uint32_t>(nodeIndex), 0, nodeData.subMeshes.size(), mergedMeshIndex });
 
             // assign merged mesh index to parent node, delete old mesh indices if any
             if (parentNode->mMeshes)
@@ -581,6 +758,14 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
             std::vector<unsigned int> meshIndices;
 
             for (size_t s = 0; s < nodeData.subMeshes.size(); s++) {
+                uint64_t contentHash = 0;
+                int instanceOf = hasLink[nodeIndex] ? -1 : findInstance(static_cast<uint32_t>(nodeIndex), s, s + 1, contentHash);
+                if (instanceOf >= 0) {
+                    meshIndices.push_back(static_cast<unsigned int>(instanceOf));
+                    instancedMeshes++;
+                    continue;
+                }
+
                 std::vector<float> vertsFlat = nodeData.verticesList[s];
                 std::vector<aiVector3D> verts;
                 for (size_t i = 0; i + 2 < vertsFlat.size(); i += 3)
@@ -668,6 +853,8 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
                 scene->mMeshes = newMeshes;
                 unsigned int newMeshIndex = scene->mNumMeshes;
                 scene->mNumMeshes++;
+                if (!hasLink[nodeIndex])
+                    meshesByContent[contentHash].push_back({ static_cast<uint32_t>(nodeIndex), s, s + 1, newMeshIndex });
 
                 meshIndices.push_back(newMeshIndex);
             }
@@ -681,34 +868,61 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
         }
     }
 
+    meshStage.End();
+    if (instancedMeshes) std::cout << "\nReusing geometry for " << instancedMeshes << " repeated mesh(es)\n";
+
     // create bones with weights on new mesh(es)
+    ProfileScope bonesStage("bone weights");
     bool anyWeights = false;
-    std::vector<std::vector<uint32_t>> bonesToAddPerMesh(scene->mNumMeshes);
     std::unordered_set<uint32_t> usedBones;
 
+    // bone names resolve through this instead of scanning allNodeNames, first node with a name wins like the scans did
+    std::unordered_map<std::string, uint32_t> nameToIndex;
+    nameToIndex.reserve(allNodeNames.size());
+    for (uint32_t i = 0; i < allNodeNames.size(); i++)
+        nameToIndex.emplace(allNodeNames[i].Name, i);
+
+    // node each scene mesh hangs off, for the offset matrices of the bones added at the end
+    std::vector<aiNode*> meshToNode(scene->mNumMeshes, nullptr);
+    for (const auto& kv : nodeMap)
+        for (unsigned int mi = 0; mi < kv.second->mNumMeshes; mi++)
+            if (!meshToNode[kv.second->mMeshes[mi]]) meshToNode[kv.second->mMeshes[mi]] = kv.second;
+
+    // one bone's row of a submesh's dense SkinnedBonesCount x VertexCount weights
+    struct WeightRow {
+        uint32_t bone;
+        const float* weights;
+        size_t vertexCount;
+        unsigned int vertexBase; // where the submesh starts in the aiMesh
+    };
+    std::vector<WeightRow> rows;
+    std::vector<uint8_t> meshDone(scene->mNumMeshes, 0);
+
     for (size_t nodeIndex = 0; nodeIndex < fullNodeDataList.size(); nodeIndex++) {
         const auto& nodeData = fullNodeDataList[nodeIndex];
         if (nodeData.subMeshes.empty()) continue;
         aiNode* parentNode = nodeMap[static_cast<unsigned int>(nodeIndex)];
         auto linkIt = std::find_if(nodeLinks.begin(), nodeLinks.end(), [&](const NodeLinks& l) { return l.MeshOffset == nodeIndex; });
 
-        size_t meshBase = (parentNode->mMeshes && parentNode->mNumMeshes > 0) ? parentNode->mMeshes[0] : 0;
         size_t vertexOffset = 0;
         size_t subCount = nodeData.subMeshes.size();
         size_t meshLoop = mergeSubmeshes ? 1 : subCount;
 
         for (size_t m = 0; m < meshLoop; m++) {
-            aiMesh* mesh = scene->mMeshes[mergeSubmeshes ? parentNode->mMeshes[0] : meshBase + m];
-            std::map<uint32_t, std::vector<aiVertexWeight>> boneWeightsMap;
+            // instanced meshes are unskinned and only need their (empty) bones set up once
+            if (meshDone[parentNode->mMeshes[m]]) continue;
+            meshDone[parentNode->mMeshes[m]] = 1;
+            aiMesh* mesh = scene->mMeshes[parentNode->mMeshes[m]];
+            rows.clear();
 
             for (size_t s = (mergeSubmeshes ? 0 : m); s < (mergeSubmeshes ? subCount : m + 1); ++s) {
                 const auto& sub = nodeData.subMeshes[s];
-                if (!sub.SkinnedBonesCount) { vertexOffset += sub.VertexCount; continue; }
+                if (!sub.SkinnedBonesCount || linkIt == nodeLinks.end()) { vertexOffset += sub.VertexCount; continue; }
 
                 uint32_t mask = sub.BonesIndexMask;
                 std::vector<uint32_t> filtered;
-                for (uint32_t i = 0; i < linkIt->BoneOffsets.size(); ++i)
-                    if (mask & (1 << i)) filtered.push_back(linkIt->BoneOffsets[i]);
+                for (uint32_t i = 0; i < linkIt->BoneOffsets.size() && i < 32; ++i)
+                    if (mask & (1u << i)) filtered.push_back(linkIt->BoneOffsets[i]);
 
                 if (!filtered.empty()) {
                     for (uint32_t idx : filtered) usedBones.insert(idx); // <-- mark as used globally
@@ -716,13 +930,10 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
 
                 size_t vertexCount = sub.VertexCount;
                 const auto& weightsFlat = nodeData.weightsList[s];
-                for (size_t b = 0; b < filtered.size(); b++) {
-                    uint32_t boneNodeIndex = filtered[b];
-                    for (size_t v = 0; v < vertexCount; v++) {
-                        float weight = weightsFlat[b * vertexCount + v];
-                        if (weight > 0.0f)
-                            boneWeightsMap[boneNodeIndex].push_back(aiVertexWeight(static_cast<unsigned int>((mergeSubmeshes ? vertexOffset : 0) + v), weight));
-                    }
+                if (weightsFlat.size() >= filtered.size() * vertexCount) {
+                    for (size_t b = 0; b < filtered.size(); b++)
+                        rows.push_back({ filtered[b], weightsFlat.data() + b * vertexCount, vertexCount,
+                            static_cast<unsigned int>(mergeSubmeshes ? vertexOffset : 0) });
                 }
 
                 vertexOffset += vertexCount;
@@ -741,28 +952,46 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
 
             mesh->mNumBones = static_cast<unsigned int>(orderedBones.size());
             mesh->mBones = new aiBone * [mesh->mNumBones];
+            std::unordered_map<uint32_t, aiBone*> boneByNode;
             size_t boneIdx = 0;
             for (uint32_t nodeIdx : orderedBones) {
                 aiBone* bone = new aiBone();
                 bone->mName = aiString(allNodeNames[nodeIdx].Name.c_str());
                 bone->mOffsetMatrix = GetOffsetMatrix(nodeMap[nodeIdx], parentNode);
+                bone->mNumWeights = 0;
+                bone->mWeights = nullptr;
+                boneByNode[nodeIdx] = bone;
+                mesh->mBones[boneIdx++] = bone;
+            }
 
-                const auto it = boneWeightsMap.find(nodeIdx);
-                if (it != boneWeightsMap.end()) {
-                    bone->mNumWeights = static_cast<unsigned int>(it->second.size());
-                    bone->mWeights = new aiVertexWeight[it->second.size()];
-                    std::copy(it->second.begin(), it->second.end(), bone->mWeights);
-                }
-                else {
-                    bone->mNumWeights = 0;
-                    bone->mWeights = nullptr;
+            // dense to sparse, non zero weights counted per bone first so each aiVertexWeight array is allocated once
+            for (const WeightRow& row : rows) {
+                aiBone* bone = boneByNode[row.bone];
+                if (!bone) continue;
+                for (size_t v = 0; v < row.vertexCount; v++)
+                    bone->mNumWeights += row.weights[v] > 0.0f;
+            }
+            for (uint32_t nodeIdx : orderedBones) {
+                aiBone* bone = boneByNode[nodeIdx];
+                if (bone->mNumWeights) bone->mWeights = new aiVertexWeight[bone->mNumWeights];
+                bone->mNumWeights = 0; // back to a fill cursor, ends up at the count again
+            }
+            for (const WeightRow& row : rows) {
+                aiBone* bone = boneByNode[row.bone];
+                if (!bone) continue;
+                for (size_t v = 0; v < row.vertexCount; v++) {
+                    float weight = row.weights[v];
+                    if (weight > 0.0f)
+                        bone->mWeights[bone->mNumWeights++] = aiVertexWeight(row.vertexBase + static_cast<unsigned int>(v), weight);
                 }
-                mesh->mBones[boneIdx++] = bone;
             }
         }
     }
 
+    bonesStage.End();
+
     // final pass: add all bones that were **used anywhere** to meshes that didn't have them yet
+    ProfileScope usedBonesStage("add used bones");
     if (anyWeights && !usedBones.empty()) {
         for (size_t meshIndex = 0; meshIndex < scene->mNumMeshes; meshIndex++) {
             aiMesh* mesh = scene->mMeshes[meshIndex];
@@ -780,12 +1009,8 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
             // collect all bones currently in mesh
             std::unordered_set<uint32_t> meshBones;
             for (size_t b = 0; b < mesh->mNumBones; b++) {
-                for (size_t idx = 0; idx < allNodeNames.size(); idx++) {
-                    if (std::string(mesh->mBones[b]->mName.C_Str()) == allNodeNames[idx].Name) {
-                        meshBones.insert(idx);
-                        break;
-                    }
-                }
+                auto it = nameToIndex.find(mesh->mBones[b]->mName.C_Str());
+                if (it != nameToIndex.end()) meshBones.insert(it->second);
             }
 
             // collect bones to add: usedBones + all parents up to armature
@@ -793,10 +1018,9 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
             for (uint32_t idx : usedBones) {
                 aiNode* n = nodeMap[idx];
                 while (n && n != armatureNode) {
-                    auto it = std::find_if(allNodeNames.begin(), allNodeNames.end(),
-                        [&](const auto& x) { return x.Name == n->mName.C_Str(); });
-                    if (it != allNodeNames.end()) {
-                        uint32_t nodeIdx = static_cast<uint32_t>(std::distance(allNodeNames.begin(), it));
+                    auto it = nameToIndex.find(n->mName.C_Str());
+                    if (it != nameToIndex.end()) {
+                        uint32_t nodeIdx = it->second;
                         if (!meshBones.count(nodeIdx)) {
                             bonesToAdd.push_back(nodeIdx);
                             meshBones.insert(nodeIdx);
@@ -817,17 +1041,8 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
             mesh->mBones = newBones;
             mesh->mNumBones = static_cast<unsigned int>(newNumBones);
 
-            // find parent node for offset matrices
-            aiNode* parentNode = nullptr;
-            for (const auto& kv : nodeMap) {
-                aiNode* n = kv.second;
-                if (n->mNumMeshes > 0) {
-                    for (unsigned int mi = 0; mi < n->mNumMeshes; mi++) {
-                        if (scene->mMeshes[n->mMeshes[mi]] == mesh) { parentNode = n; break; }
-                    }
-                    if (parentNode) break;
-                }
-            }
+            // parent node for offset matrices
+            aiNode* parentNode = meshToNode[meshIndex];
 
             // add new bones
             size_t boneIdx = oldNumBones;
@@ -842,142 +1057,210 @@ void SaveDaeFile(const std::string& path, const std::string& outDir, Header& hea
         }
     }
 
-    std::cout << std::endl << "Writing preset..." << std::endl;
-    // convoluted preset name script lol
-    std::string presetFilename = path.substr(path.find_last_of("/\\") + 1);
-    presetFilename = presetFilename.substr(0, presetFilename.find_last_of('.') == std::string::npos ? presetFilename.size() : presetFilename.find_last_of('.'));
-    presetFilename = presetFilename.substr(0, presetFilename.find_first_of(' ') == std::string::npos ? presetFilename.size() : presetFilename.find_first_of(' '));
-    std::string result;
-    bool capitalize = true;
-    for (char c : presetFilename) {
-        if (c == '_' || c == '-') { capitalize = true; continue; }
-        result += capitalize ? (char)toupper(c) : c;
-        capitalize = false;
-    }
-    if (result.size() >= 5 && result.substr(result.size() - 5) == "Model") result = result.substr(0, result.size() - 5);
-    std::string presetPath = MakeOutFilePath(result + "_Preset.txt", outDir);
-    WritePresetFile(presetPath, materialsData, textureNames, allNodeNames, fullNodeDataList);
+    usedBonesStage.End();
 
-    std::cout << std::endl << "Writing collada .dae..." << std::endl;
+    return scene;
+}
 
-    Assimp::Exporter exporter;
-    std::string outFile = path.substr(0, path.find_last_of('.')) + "_out.dae";
-    outFile = MakeOutFilePath(outFile, outDir);
-    aiReturn rc;
-    {
+void SaveDaeFile(const std::string& path, const std::string& outDir, Header& headerData, std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
+    std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes, uint32_t formats)
+{
+    PROFILE_SCOPE("SaveDaeFile");
+
+    // used for post processing dae patching to fix materials on a single mesh, assimp can only export 1 mat per mesh
+    std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>> allMaterialToIndices;
+    aiScene* scene = BuildExportScene(headerData, materialsData, textureNames, nodeLinks, allNodeNames, rootNodes, fullNodeDataList, mergeSubmeshes, allMaterialToIndices);
+
+    std::string presetFilename;
+    std::string presetPath = MakePresetPath(path, outDir, presetFilename);
+
+    std::string basePath = MakeOutFilePath(path.substr(0, path.find_last_of('.')) + "_out", outDir);
+    std::string outFile = basePath + ".dae";
+    std::string gltfPath = basePath + ".gltf";
+    std::string glbPath = basePath + ".glb";
+
+    std::string fbxPath = basePath + ".fbx";
+    bool haveFbxTool = (formats & ExportFbx) && HaveFbxConverter();
+
+    // each output gets its own thread, they only read the scene and model data (assimp exports from its own copy of the scene)
+    std::vector<std::thread> writers;
+    std::mutex failedLock;
+    std::vector<std::string> failed;
+    int profileStage = CurrentProfileStage();
+    auto startWriter = [&](const char* name, std::function<void()> write) {
+        writers.emplace_back([&failedLock, &failed, name, write, profileStage]() {
+            SetTraceThreadName(name);
+            ProfileThreadParent profileParent(profileStage);
+            PROFILE_SCOPE(name);
+            try {
+                write();
+            }
+            catch (const std::exception& e) {
+                std::lock_guard<std::mutex> lock(failedLock);
+                failed.push_back(std::string(name) + ": " + e.what());
+            }
+        });
+    };
+    auto exportScene = [scene](const char* formatId, const std::string& outPath) {
         Assimp::Exporter exporter;
-        rc = exporter.Export(scene, "collada", outFile);
+        if (exporter.Export(scene, formatId, outPath) != aiReturn_SUCCESS)
+            throw std::runtime_error(exporter.GetErrorString());
+    };
+
+    if (formats & ExportPreset) {
+        std::cout << std::endl << "Writing preset..." << std::endl;
+        startWriter("write preset", [&]() { WritePresetFile(presetPath, materialsData, textureNames, allNodeNames, fullNodeDataList); });
+    }
+    if (formats & ExportGltf) {
+        std::cout << std::endl << "Writing .gltf..." << std::endl;
+        startWriter("gltf export", [&]() { exportScene("gltf2", gltfPath); });
+    }
+    if (formats & ExportGlb) {
+        std::cout << std::endl << "Writing .glb..." << std::endl;
+        startWriter("glb export", [&]() { exportScene("glb2", glbPath); });
     }
 
-    CallPatchDaeFileDLL(outFile, allMaterialToIndices);
-    CallGetNormalsFromDLL(outFile);
-    std::cout << std::endl << "Saved file as " << outFile << std::endl;
+    if (formats & ExportNormals) {
+        std::cout << std::endl << "Writing normals..." << std::endl;
+        startWriter("normals sidecar", [&]() { WriteNormalsSidecar(basePath, scene); });
+    }
 
-    // convert to fbx thanks autodesk for coming in clutch
-    struct stat buf;
-    std::string exePath = exeDir + "\\fbxtool\\FbxConverter.exe";
-    std::string fbxPath = outFile.substr(0, outFile.find_last_of('.')) + ".fbx";
-    if (stat(exePath.c_str(), &buf) == 0) {
-        std::string cmd = "\"" + exePath + "\" \"" + outFile + "\" \"" + fbxPath + "\"";
-        cmd = "\"" + cmd + "\"";
-        //std::cout << "running command: " << cmd << std::endl;
-        system(cmd.c_str());
+    // fbx is converted from the patched dae so it chains after it
+    if (formats & (ExportDae | ExportFbx)) {
+        std::cout << std::endl << "Writing collada .dae..." << std::endl;
+        startWriter("collada", [&]() {
+            {
+                PROFILE_SCOPE("assimp export");
+                exportScene("collada", outFile);
+            }
+            {
+                PROFILE_SCOPE("PatchDaeFile");
+                CallPatchDaeFileDLL(outFile, allMaterialToIndices);
+            }
+            if (haveFbxTool) RunFbxConverter(outFile, fbxPath);
+
+            // only written for the fbx to be made from
+            if (!(formats & ExportDae)) remove(outFile.c_str());
+        });
     }
 
-	std::ofstream(logPath.c_str(), std::ios::trunc) << "Saved collada file to " << outFile << "\nAlong with Maya py script to import normals\n\nBlender users must open created FBX imported at scale 100\n\nCreated " << presetFilename + "Preset.txt" << " file for MKDX importing" << std::endl;
+    for (auto& writer : writers) writer.join();
+
+    std::ostringstream log;
+    if (formats & ExportDae) {
+        std::cout << std::endl << "Saved file as " << outFile << std::endl;
+        log << "Saved collada file to " << outFile << "\n";
+    }
+    if (formats & ExportNormals) {
+        std::cout << "\nMaya py script to import normals after dae import: " << basePath << "_normals.txt <- run that in script editor!\n";
+        log << "Along with Maya py script to import normals\n";
+    }
+    if (haveFbxTool) log << "\nBlender users must open created FBX imported at scale 100\n";
+    if (formats & ExportGltf) log << "\nSaved glTF file to " << gltfPath << "\n";
+    if (formats & ExportGlb) log << "\nSaved glb file to " << glbPath << "\n";
+    if (formats & ExportPreset) log << "\nCreated " << presetFilename + "Preset.txt" << " file for MKDX importing\n";
+    for (const std::string& f : failed) {
+        std::cerr << "Failed " << f << "\n";
+        log << "\nFailed " << f << "\n";
+    }
+	std::ofstream(logPath.c_str(), std::ios::trunc) << log.str();
 }
 
 void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& header, std::vector<Material>& materialsData,
     std::vector<TextureName>& textureNames, std::vector<NodeNames>& boneNames,
     std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
-    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList)
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, IOStats* stats)
 {
+    PROFILE_SCOPE("SaveMKDXFile");
+    IOStatsScope ioStatsScope(stats);
     std::string outFile = path.substr(0, path.find_last_of('.')) + "_out.bin";
     outFile = MakeOutFilePath(outFile, outDir);
     std::ofstream writer(outFile, std::ios::binary);
 
     // Write the header with all offsets as 0 for now
-    writer.write("BIKE", 4);
-    writer.write(reinterpret_cast<char*>(&header.Type), sizeof(header.Type));
-    writer.write(reinterpret_cast<char*>(&header.Unknown), sizeof(header.Unknown));
-    writer.write(reinterpret_cast<char*>(&header.Alignment), sizeof(header.Alignment));
-    writer.write(reinterpret_cast<char*>(&header.Padding), sizeof(header.Padding));
-
-    writer.write(reinterpret_cast<char*>(&header.MaterialCount), sizeof(header.MaterialCount));
+    ProfileScope tablesStage("header + tables");
+    WriteBytes(writer, "BIKE", 4);
+    WriteBytes(writer, &header.Type, sizeof(header.Type));
+    WriteBytes(writer, &header.Unknown, sizeof(header.Unknown));
+    WriteBytes(writer, &header.Alignment, sizeof(header.Alignment));
+    WriteBytes(writer, &header.Padding, sizeof(header.Padding));
+
+    WriteBytes(writer, &header.MaterialCount, sizeof(header.MaterialCount));
     std::streampos posMaterialArrayOffset = writer.tellp();
     uint32_t zero32 = 0;
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // Placeholder for MaterialArrayOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // Placeholder for MaterialArrayOffset
 
-    writer.write(reinterpret_cast<char*>(&header.TextureMapsCount), sizeof(header.TextureMapsCount));
+    WriteBytes(writer, &header.TextureMapsCount, sizeof(header.TextureMapsCount));
     std::streampos posTextureNameArrayOffset = writer.tellp();
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // TextureNameArrayOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // TextureNameArrayOffset
 
-    writer.write(reinterpret_cast<char*>(&header.BoneCount), sizeof(header.BoneCount));
+    WriteBytes(writer, &header.BoneCount, sizeof(header.BoneCount));
     std::streampos posBoneNameArrayOffset = writer.tellp();
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // BoneNameArrayOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // BoneNameArrayOffset
 
     std::streampos posRootNodeArrayOffset = writer.tellp();
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // RootNodeArrayOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // RootNodeArrayOffset
 
-    writer.write(reinterpret_cast<char*>(&header.LinkNodeCount), sizeof(header.LinkNodeCount));
+    WriteBytes(writer, &header.LinkNodeCount, sizeof(header.LinkNodeCount));
     std::streampos posLinkNodeOffset = writer.tellp();
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // LinkNodeOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // LinkNodeOffset
 
-    writer.write(reinterpret_cast<char*>(&header.TotalNodeCount), sizeof(header.TotalNodeCount));
+    WriteBytes(writer, &header.TotalNodeCount, sizeof(header.TotalNodeCount));
     std::streampos posTotalNodeArrayOffset = writer.tellp();
-    writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // TotalNodeArrayOffset
+    WriteBytes(writer, &zero32, sizeof(uint32_t)); // TotalNodeArrayOffset
 
-    writer.write(reinterpret_cast<char*>(&header.Padding2), sizeof(header.Padding2));
+    WriteBytes(writer, &header.Padding2, sizeof(header.Padding2));
 
     // Write each material in the same order/format as ReadMaterial
     std::streampos materialArrayOffset = writer.tellp(); // for pointer add marathon at the end
     for (const auto& mat : materialsData)
     {
         for (uint32_t f : mat.Unknowns)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(uint32_t));
+            WriteBytes(writer, &f, sizeof(uint32_t));
         for (uint32_t f : mat.UnknownValues)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(uint32_t));
+            WriteBytes(writer, &f, sizeof(uint32_t));
         for (float f : mat.Diffuse)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(float));
+            WriteBytes(writer, &f, sizeof(float));
         for (float f : mat.Specular)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(float));
+            WriteBytes(writer, &f, sizeof(float));
         for (float f : mat.Ambience)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(float));
+            WriteBytes(writer, &f, sizeof(float));
 
-        writer.write(reinterpret_cast<const char*>(&mat.Shiny), sizeof(float));
+        WriteBytes(writer, &mat.Shiny, sizeof(float));
 
         for (float f : mat.Unknowns2)
-            writer.write(reinterpret_cast<char*>(&f), sizeof(float));
+            WriteBytes(writer, &f, sizeof(float));
         for (uint16_t s : mat.TextureIndices)
-            writer.write(reinterpret_cast<char*>(&s), sizeof(uint16_t));
+            WriteBytes(writer, &s, sizeof(uint16_t));
     }
 
     // write 00 padding til at the next line
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
 
     // write all texture name pointers (as blanks for now)
     std::streampos posTextureNameArray = writer.tellp();
     for (size_t i = 0; i < textureNames.size(); i++)
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t)); // write pair.key later after updating them to new values
+        WriteBytes(writer, &zero32, sizeof(uint32_t)); // write pair.key later after updating them to new values
 
     // pad to next line again
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
 
     // the boneNames chunk is entirely pointers so just all 0s for now
     std::streampos posBoneNamesArray = writer.tellp();
     for (uint32_t i = 0; i < header.BoneCount; i++)
     {
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
+        WriteBytes(writer, &zero32, sizeof(uint32_t));
+        WriteBytes(writer, &zero32, sizeof(uint32_t));
     }
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
 
     // write root node pointers as blanks
     std::streampos posRootNodeArray = writer.tellp();
     for (size_t i = 0; i < rootNodes.size(); i++)
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
+        WriteBytes(writer, &zero32, sizeof(uint32_t));
 
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
 
     // write links data (two blank pointers then uint index of bone on mesh)
     std::streampos posLinkNodeArray = writer.tellp();
@@ -985,109 +1268,96 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
     {
         for (size_t i = 0; i < link.BoneOffsets.size(); i++)
         {
-            writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
-            writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
+            WriteBytes(writer, &zero32, sizeof(uint32_t));
+            WriteBytes(writer, &zero32, sizeof(uint32_t));
             uint32_t index = static_cast<uint32_t>(i);
-            writer.write(reinterpret_cast<char*>(&index), sizeof(uint32_t)); // index of bone on mesh
+            WriteBytes(writer, &index, sizeof(uint32_t)); // index of bone on mesh
         }
     }
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
 
     // the allNodeNames chunk is also entirely pointers so just all 0s for now x2
     std::streampos posAllNodeNamesArray = writer.tellp();
     for (uint32_t i = 0; i < header.TotalNodeCount; i++)
     {
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
-        writer.write(reinterpret_cast<char*>(&zero32), sizeof(uint32_t));
+        WriteBytes(writer, &zero32, sizeof(uint32_t));
+        WriteBytes(writer, &zero32, sizeof(uint32_t));
     }
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+
 
+    tablesStage.End();
 
     // start writing children of first bone (appears first in data)
+    ProfileScope nodeDataStage("node data");
     std::vector<std::pair<int, uint32_t>> nodeUpdates, boneUpdates;
     std::vector<uint32_t> subMeshOffsetsList;
     int j = 0;
 
+    // byte identical buffers are written once and every submesh offset that wants one points at that copy, offsets are
+    // absolute so the game reads a shared buffer like any other (uv1-3 copies of uv0, same colours, repeated meshes)
+    struct WrittenBuffer {
+        uint32_t offset;
+        const void* data; // still owned by fullNodeDataList, compared against on a hash hit
+        size_t size;
+    };
+    std::unordered_map<uint64_t, std::vector<WrittenBuffer>> writtenBuffers;
+    size_t sharedBuffers = 0, sharedBytes = 0;
+    auto writeBuffer = [&](const auto& buffer) -> uint32_t {
+        const void* data = buffer.data();
+        size_t size = buffer.size() * sizeof(buffer[0]);
+        std::vector<WrittenBuffer>& candidates = writtenBuffers[HashBuffer(buffer)];
+        for (const WrittenBuffer& written : candidates) {
+            if (written.size == size && (size == 0 || memcmp(written.data, data, size) == 0)) {
+                sharedBuffers++;
+                sharedBytes += size;
+                return written.offset;
+            }
+        }
+
+        uint32_t offset = static_cast<uint32_t>(writer.tellp());
+        WriteBytes(writer, data, size);
+        WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16); // new row
+        candidates.push_back({ offset, data, size });
+        return offset;
+    };
+
     for (auto& fullNodeData : fullNodeDataList) {
         subMeshOffsetsList.clear();
         // write submesh data in order by looping through each submesh, writing all data it points to in order of appearance (all 9 buffers if current offset value > 0) then write the submesh data itself
         for (size_t i = 0; i < fullNodeData.subMeshes.size(); i++) {
             auto& submesh = fullNodeData.subMeshes[i];
 
-            if (submesh.VertexPositionOffset > 0) {
-                submesh.VertexPositionOffset = writer.tellp();
-                for (float val : fullNodeData.verticesList[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16); // new row
-            }
-
-            if (submesh.VertexNormalOffset > 0) {
-                submesh.VertexNormalOffset = writer.tellp();
-                for (float val : fullNodeData.normalsList[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16); // new row
-            }
-
-            if (submesh.ColorBufferOffset > 0) {
-                submesh.ColorBufferOffset = writer.tellp();
-                for (float val : fullNodeData.colorsList[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.TexCoord0Offset > 0) {
-                submesh.TexCoord0Offset = writer.tellp();
-                for (float val : fullNodeData.uvs0List[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.TexCoord1Offset > 0) {
-                submesh.TexCoord1Offset = writer.tellp();
-                for (float val : fullNodeData.uvs1List[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.TexCoord2Offset > 0) {
-                submesh.TexCoord2Offset = writer.tellp();
-                for (float val : fullNodeData.uvs2List[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.TexCoord3Offset > 0) {
-                submesh.TexCoord3Offset = writer.tellp();
-                for (float val : fullNodeData.uvs3List[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.FaceOffset > 0) {
-                submesh.FaceOffset = writer.tellp();
-                for (int16_t val : fullNodeData.polygonsList[i]) writer.write((char*)&val, sizeof(int16_t));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
-
-            if (submesh.WeightOffset > 0) {
-                submesh.WeightOffset = writer.tellp();
-                for (float val : fullNodeData.weightsList[i]) writer.write((char*)&val, sizeof(float));
-                writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
-            }
+            if (submesh.VertexPositionOffset > 0) submesh.VertexPositionOffset = writeBuffer(fullNodeData.verticesList[i]);
+            if (submesh.VertexNormalOffset > 0) submesh.VertexNormalOffset = writeBuffer(fullNodeData.normalsList[i]);
+            if (submesh.ColorBufferOffset > 0) submesh.ColorBufferOffset = writeBuffer(fullNodeData.colorsList[i]);
+            if (submesh.TexCoord0Offset > 0) submesh.TexCoord0Offset = writeBuffer(fullNodeData.uvs0List[i]);
+            if (submesh.TexCoord1Offset > 0) submesh.TexCoord1Offset = writeBuffer(fullNodeData.uvs1List[i]);
+            if (submesh.TexCoord2Offset > 0) submesh.TexCoord2Offset = writeBuffer(fullNodeData.uvs2List[i]);
+            if (submesh.TexCoord3Offset > 0) submesh.TexCoord3Offset = writeBuffer(fullNodeData.uvs3List[i]);
+            if (submesh.FaceOffset > 0) submesh.FaceOffset = writeBuffer(fullNodeData.polygonsList[i]);
+            if (submesh.WeightOffset > 0) submesh.WeightOffset = writeBuffer(fullNodeData.weightsList[i]);
 
 			// write submesh data block (the pointers etc not the buffers)
             subMeshOffsetsList.push_back(writer.tellp());
-            writer.write((char*)&submesh.Padding, sizeof(uint32_t));
-            writer.write((char*)&submesh.TriangleCount, sizeof(uint32_t));
-            writer.write((char*)&submesh.MaterialIndex, sizeof(uint32_t));
-            for (float f : submesh.BoundingBox) writer.write((char*)&f, sizeof(float));
-            writer.write((char*)&submesh.VertexCount, sizeof(uint32_t));
-            writer.write((char*)&submesh.VertexPositionOffset, sizeof(uint32_t));
-            writer.write((char*)&submesh.VertexNormalOffset, sizeof(uint32_t));
-            writer.write((char*)&submesh.ColorBufferOffset, sizeof(uint32_t));
-            writer.write((char*)&submesh.TexCoord0Offset, sizeof(uint32_t));
-            writer.write((char*)&submesh.TexCoord1Offset, sizeof(uint32_t));
-            writer.write((char*)&submesh.TexCoord2Offset, sizeof(uint32_t));
-            writer.write((char*)&submesh.TexCoord3Offset, sizeof(uint32_t));
-            writer.write((char*)&submesh.FaceOffset, sizeof(uint32_t));
-            writer.write((char*)&submesh.SkinnedBonesCount, sizeof(uint32_t));
-            writer.write((char*)&submesh.BonesIndexMask, sizeof(uint32_t));
-            writer.write((char*)&submesh.WeightOffset, sizeof(uint32_t));
-            for (float f : submesh.BoundingBoxMaxMin) writer.write((char*)&f, sizeof(float));
-            writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+            WriteBytes(writer, &submesh.Padding, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.TriangleCount, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.MaterialIndex, sizeof(uint32_t));
+            for (float f : submesh.BoundingBox) WriteBytes(writer, &f, sizeof(float));
+            WriteBytes(writer, &submesh.VertexCount, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.VertexPositionOffset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.VertexNormalOffset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.ColorBufferOffset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.TexCoord0Offset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.TexCoord1Offset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.TexCoord2Offset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.TexCoord3Offset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.FaceOffset, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.SkinnedBonesCount, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.BonesIndexMask, sizeof(uint32_t));
+            WriteBytes(writer, &submesh.WeightOffset, sizeof(uint32_t));
+            for (float f : submesh.BoundingBoxMaxMin) WriteBytes(writer, &f, sizeof(float));
+            WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
         }
 
         // write pointers for submeshes, but empty pointers for node children
@@ -1095,9 +1365,9 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
         uint32_t subMeshesOffset = 0;
         if (!fullNodeData.subMeshes.empty()) {
             subMeshesOffset = writer.tellp();
-            for (uint32_t offset : subMeshOffsetsList) writer.write((char*)&offset, sizeof(uint32_t));
-            writer.write((char*)&zero32, sizeof(uint32_t));
-            writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+            for (uint32_t offset : subMeshOffsetsList) WriteBytes(writer, &offset, sizeof(uint32_t));
+            WriteBytes(writer, &zero32, sizeof(uint32_t));
+            WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
         }
 
         // even tho we write all submesh offsets, write blanks for children node offsets because each of these are added later
@@ -1106,10 +1376,10 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
         if (!fullNodeData.childrenIndexList.empty()) {
             childNodesOffset = writer.tellp();
             for (size_t i = 0; i < fullNodeData.childrenIndexList.size(); i++) {
-                writer.write((char*)&zero32, sizeof(uint32_t));
+                WriteBytes(writer, &zero32, sizeof(uint32_t));
             }
-            writer.write((char*)&zero32, sizeof(uint32_t)); // pointer array must end with 0
-            writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+            WriteBytes(writer, &zero32, sizeof(uint32_t)); // pointer array must end with 0
+            WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
         }
 
         // update node data pointers since data is written last
@@ -1131,25 +1401,28 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
 
         // write all node data
         auto& bone = fullNodeData.boneData;
-        writer.write((char*)&bone.Visibility, sizeof(uint32_t));
-        for (float f : bone.Scale) writer.write((char*)&f, sizeof(float));
-        for (float f : bone.Rotation) writer.write((char*)&f, sizeof(float));
-        for (float f : bone.Translation) writer.write((char*)&f, sizeof(float));
-        for (float u : bone.BoundingBox) writer.write((char*)&u, sizeof(float));
-        writer.write((char*)&bone.ModelObjectArrayOffset, sizeof(uint32_t));
-        writer.write((char*)&bone.ChildrenArrayOffset, sizeof(uint32_t));
-        for (float f : bone.MoreFloats) writer.write((char*)&f, sizeof(float));
-        for (float u : bone.AnimationVals) writer.write((char*)&u, sizeof(float));
-        for (float u : bone.BoundingBoxMaxMin) writer.write((char*)&u, sizeof(float));
+        WriteBytes(writer, &bone.Visibility, sizeof(uint32_t));
+        for (float f : bone.Scale) WriteBytes(writer, &f, sizeof(float));
+        for (float f : bone.Rotation) WriteBytes(writer, &f, sizeof(float));
+        for (float f : bone.Translation) WriteBytes(writer, &f, sizeof(float));
+        for (float u : bone.BoundingBox) WriteBytes(writer, &u, sizeof(float));
+        WriteBytes(writer, &bone.ModelObjectArrayOffset, sizeof(uint32_t));
+        WriteBytes(writer, &bone.ChildrenArrayOffset, sizeof(uint32_t));
+        for (float f : bone.MoreFloats) WriteBytes(writer, &f, sizeof(float));
+        for (float u : bone.AnimationVals) WriteBytes(writer, &u, sizeof(float));
+        for (float u : bone.BoundingBoxMaxMin) WriteBytes(writer, &u, sizeof(float));
         uint32_t pad = 0;
-        writer.write((char*)&pad, sizeof(uint32_t)); // pad
+        WriteBytes(writer, &pad, sizeof(uint32_t)); // pad
 
         j++;
     }
 
-    writer.write(std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+    WriteBytes(writer, std::vector<char>((16 - writer.tellp() % 16) % 16, 0).data(), (16 - writer.tellp() % 16) % 16);
+
+    nodeDataStage.End();
 
     // update node and bone names lists with the pointers created in last loop
+    ProfileScope fixupStage("names + pointer fixups");
     for (const auto& pair : nodeUpdates) {
         int index = pair.first;
         uint32_t newOffset = pair.second;
@@ -1166,8 +1439,8 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
     // Update all texture name pointers (in memory)
     for (size_t i = 0; i < textureNames.size(); i++) {
         uint32_t offset = static_cast<uint32_t>(writer.tellp());
-        writer.write(textureNames[i].Name.c_str(), textureNames[i].Name.size());
-        writer.put(0); // null terminator
+        WriteBytes(writer, textureNames[i].Name.c_str(), textureNames[i].Name.size());
+        WriteBytes(writer, "", 1); // null terminator
 
         textureNames[i].NamePointer = offset; // use offsets after seeking to posTextureNameArray (not posTextureNameArrayOffset, thats the pointer TO the array)
     }
@@ -1175,8 +1448,8 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
     // Update all bone name pointers (in memory)
     for (size_t i = 0; i < boneNames.size(); i++) {
         uint32_t offset = static_cast<uint32_t>(writer.tellp());
-        writer.write(boneNames[i].Name.c_str(), boneNames[i].Name.size());
-        writer.put(0); // null terminator
+        WriteBytes(writer, boneNames[i].Name.c_str(), boneNames[i].Name.size());
+        WriteBytes(writer, "", 1); // null terminator
 
         boneNames[i].NamePointer = offset;
     }
@@ -1184,73 +1457,75 @@ void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& he
     // Update all node name pointers (in memory)
     for (size_t i = 0; i < allNodeNames.size(); i++) {
         uint32_t offset = static_cast<uint32_t>(writer.tellp());
-        writer.write(allNodeNames[i].Name.c_str(), allNodeNames[i].Name.size());
-        writer.put(0); // null terminator
+        WriteBytes(writer, allNodeNames[i].Name.c_str(), allNodeNames[i].Name.size());
+        WriteBytes(writer, "", 1); // null terminator
 
         allNodeNames[i].NamePointer = offset;
     }
 
     // Update all pointers in out file (seek to variables that start with 'pos')
     if (header.MaterialCount)
-        writer.seekp(posMaterialArrayOffset), writer.write(reinterpret_cast<char*>(&materialArrayOffset), sizeof(uint32_t));
+        SeekWritePos(writer, posMaterialArrayOffset), WriteBytes(writer, &materialArrayOffset, sizeof(uint32_t));
 
     if (header.TextureMapsCount)
-        writer.seekp(posTextureNameArrayOffset), writer.write(reinterpret_cast<char*>(&posTextureNameArray), sizeof(uint32_t));
+        SeekWritePos(writer, posTextureNameArrayOffset), WriteBytes(writer, &posTextureNameArray, sizeof(uint32_t));
 
     if (header.BoneCount)
-        writer.seekp(posBoneNameArrayOffset), writer.write(reinterpret_cast<char*>(&posBoneNamesArray), sizeof(uint32_t));
+        SeekWritePos(writer, posBoneNameArrayOffset), WriteBytes(writer, &posBoneNamesArray, sizeof(uint32_t));
 
-    writer.seekp(posRootNodeArrayOffset), writer.write(reinterpret_cast<char*>(&posRootNodeArray), sizeof(uint32_t));
+    SeekWritePos(writer, posRootNodeArrayOffset), WriteBytes(writer, &posRootNodeArray, sizeof(uint32_t));
 
     if (header.LinkNodeCount)
-        writer.seekp(posLinkNodeOffset), writer.write(reinterpret_cast<char*>(&posLinkNodeArray), sizeof(uint32_t));
+        SeekWritePos(writer, posLinkNodeOffset), WriteBytes(writer, &posLinkNodeArray, sizeof(uint32_t));
 
     if (header.TotalNodeCount)
-        writer.seekp(posTotalNodeArrayOffset), writer.write(reinterpret_cast<char*>(&posAllNodeNamesArray), sizeof(uint32_t));
+        SeekWritePos(writer, posTotalNodeArrayOffset), WriteBytes(writer, &posAllNodeNamesArray, sizeof(uint32_t));
 
-    writer.seekp(posTextureNameArray);
+    SeekWritePos(writer, posTextureNameArray);
     for (size_t i = 0; i < textureNames.size(); i++)
-        writer.write(reinterpret_cast<char*>(&textureNames[i].NamePointer), sizeof(uint32_t));
+        WriteBytes(writer, &textureNames[i].NamePointer, sizeof(uint32_t));
 
-    writer.seekp(posBoneNamesArray);
+    SeekWritePos(writer, posBoneNamesArray);
     for (uint32_t i = 0; i < header.BoneCount; i++) {
-        writer.write(reinterpret_cast<char*>(&boneNames[i].NamePointer), sizeof(uint32_t));
-        writer.write(reinterpret_cast<char*>(&boneNames[i].DataOffset), sizeof(uint32_t));
+        WriteBytes(writer, &boneNames[i].NamePointer, sizeof(uint32_t));
+        WriteBytes(writer, &boneNames[i].DataOffset, sizeof(uint32_t));
     }
 
-    writer.seekp(posRootNodeArray);
+    SeekWritePos(writer, posRootNodeArray);
     for (size_t i = 0; i < rootNodes.size(); i++) {
         int index = static_cast<int>(rootNodes[i]);
-        writer.write(reinterpret_cast<char*>(&allNodeNames[index].DataOffset), sizeof(uint32_t));
+        WriteBytes(writer, &allNodeNames[index].DataOffset, sizeof(uint32_t));
     }
 
     for (const auto& nodeData : fullNodeDataList) {
-        writer.seekp(nodeData.boneData.ChildrenArrayOffset);
+        SeekWritePos(writer, nodeData.boneData.ChildrenArrayOffset);
         for (const auto& childIndex : nodeData.childrenIndexList) {
             uint32_t childOffset = allNodeNames[static_cast<int>(childIndex)].DataOffset;
-            writer.write(reinterpret_cast<char*>(&childOffset), sizeof(uint32_t));
+            WriteBytes(writer, &childOffset, sizeof(uint32_t));
         }
     }
 
-    writer.seekp(posLinkNodeArray);
+    SeekWritePos(writer, posLinkNodeArray);
     for (const auto& link : nodeLinks) {
         uint32_t meshDataOffset = allNodeNames[static_cast<int>(link.MeshOffset)].DataOffset; // mesh offset index to actual offset
         for (size_t i = 0; i < link.BoneOffsets.size(); i++) {
             uint32_t boneDataOffset = allNodeNames[static_cast<int>(link.BoneOffsets[i])].DataOffset; // bone offset index to actual offset
-            writer.write(reinterpret_cast<char*>(&meshDataOffset), sizeof(uint32_t));
-            writer.write(reinterpret_cast<char*>(&boneDataOffset), sizeof(uint32_t));
+            WriteBytes(writer, &meshDataOffset, sizeof(uint32_t));
+            WriteBytes(writer, &boneDataOffset, sizeof(uint32_t));
             uint32_t index = static_cast<uint32_t>(i);
-            writer.write(reinterpret_cast<char*>(&index), sizeof(uint32_t));
+            WriteBytes(writer, &index, sizeof(uint32_t));
         }
     }
 
-    writer.seekp(posAllNodeNamesArray);
+    SeekWritePos(writer, posAllNodeNamesArray);
     for (uint32_t i = 0; i < header.TotalNodeCount; i++) {
-        writer.write(reinterpret_cast<char*>(&allNodeNames[i].NamePointer), sizeof(uint32_t));
-        writer.write(reinterpret_cast<char*>(&allNodeNames[i].DataOffset), sizeof(uint32_t));
+        WriteBytes(writer, &allNodeNames[i].NamePointer, sizeof(uint32_t));
+        WriteBytes(writer, &allNodeNames[i].DataOffset, sizeof(uint32_t));
     }
 
     writer.close();
+    fixupStage.End();
     std::cout << "\nSaved binary MKDX file to " << outFile << std::endl;
+    if (sharedBuffers) std::cout << std::dec << sharedBuffers << " duplicate buffer(s) shared, " << sharedBytes / 1024 << " KB saved" << std::endl;
     std::ofstream(logPath.c_str(), std::ios::trunc) << "Saved binary MKDX file to " << outFile << std::endl;
 }
\ No newline at end of file
@@ -2,18 +2,90 @@
 
 #include <string>
 #include <vector>
+#include <fstream>
+#include <unordered_map>
 #include "CoolStructs.h"
+#include "IOStats.h"
+
+struct aiScene;
 
 void SaveMKDXFile(const std::string& path, const std::string& outDir, Header& headerData, std::vector<Material>& materialsData,
     std::vector<TextureName>& textureNames, std::vector<NodeNames>& boneNames,
     std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
-    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList);
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, IOStats* stats = nullptr);
+
+// builds the assimp scene SaveDaeFile exports, allMaterialToIndices gets the per-mesh material splits the dae patch needs
+aiScene* BuildExportScene(Header& headerData, std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
+    std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes,
+    std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>>& allMaterialToIndices);
 
+// builds the scene once then runs a writer thread per output in formats (ExportFormat bits), fbx is made from the
+// patched .dae so asking for it writes that too, it's deleted again after if dae wasn't asked for
 void SaveDaeFile(const std::string& path, const std::string& outDir, Header& headerData, std::vector<Material>& materialsData, std::vector<TextureName>& textureNames,
     std::vector<NodeLinks>& nodeLinks, std::vector<NodeNames>& allNodeNames,
-    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes);
+    std::vector<uint32_t>& rootNodes, std::vector<FullNodeData>& fullNodeDataList, const bool mergeSubmeshes, uint32_t formats = ExportDefault);
+
+MKDXData LoadMKDXFile(std::ifstream& fs, IOStats* stats = nullptr);
+
+// everything LoadMKDXFile reads except the vertex/index/weight buffers, fs is left open to read them node by node
+MKDXData LoadMKDXLayout(std::istream& fs, IOStats* stats = nullptr);
+// fills the node's buffer lists from fs (weightsOnly skips the rest), FreeNodeBuffers hands the memory back
+void LoadNodeBuffers(std::istream& fs, FullNodeData& node, bool weightsOnly = false);
+void FreeNodeBuffers(FullNodeData& node);
+
+// <outDir>\<filename of path>, slashes turned into backslashes
+std::string MakeOutFilePath(const std::string& path, const std::string& outDir);
+
+// the name PatchDaeFile_C leaves on each geometry, called in library_geometries order: a name seen before gets _2, _3...
+// (skipping any already taken), Maya names its shapes after these
+class GeometryNamer {
+public:
+    std::string Next(const std::string& name);
+
+private:
+    std::unordered_map<std::string, int> nameCounts;
+};
+
+// custom normals for Maya without reparsing the dae, each geometry's vertex normals go into a packed <outBase>_normals.bin
+// and <outBase>_normals.txt is just a loader that reads it in one go, add meshes in dae order with their GeometryNamer name
+class NormalsSidecar {
+public:
+    explicit NormalsSidecar(const std::string& outBase);
+    ~NormalsSidecar();
+
+    void AddMesh(const std::string& geometryName, const float* normals, uint32_t count);
+    // writes the mesh count and the loader script, the destructor does it if nobody did
+    void Finish();
+
+    NormalsSidecar(const NormalsSidecar&) = delete;
+    NormalsSidecar& operator=(const NormalsSidecar&) = delete;
+
+private:
+    std::string binPath;
+    std::string scriptPath;
+    std::ofstream bin;
+    std::streampos meshCountPos = 0;
+    uint32_t meshCount = 0;
+};
+
+// sidecar for the meshes of an export scene, one entry per scene mesh so instanced geometry is only in it once
+void WriteNormalsSidecar(const std::string& outBase, const aiScene* scene);
+
+// material preset for importing the model back, only needs the layout (no buffers)
+int WritePresetFile(const std::string& path, const std::vector<Material>& materialsData,
+    const std::vector<TextureName>& textureNames, const std::vector<NodeNames>& allNodeNames,
+    const std::vector<FullNodeData>& fullNodeDataList);
+
+// <outDir>\<Name>_Preset.txt from the .bin name, presetFilename gets the name it was made from
+std::string MakePresetPath(const std::string& path, const std::string& outDir, std::string& presetFilename);
+
+// fbxtool\FbxConverter.exe next to the exe
+bool HaveFbxConverter();
+void RunFbxConverter(const std::string& daePath, const std::string& fbxPath);
 
-MKDXData LoadMKDXFile(std::ifstream& fs);
+// splits assimp's one material per mesh back into the per-submesh materials from BuildExportScene
+void CallPatchDaeFileDLL(const std::string& outFile, const std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>>& allMaterialToIndices);
 
 extern std::string logPath;
 extern std::string exeDir;
\ No newline at end of file
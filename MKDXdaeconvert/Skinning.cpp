@@ -0,0 +1,207 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "Skinning.h"
+#include "AnimEval.h"
+#include "Profiler.h"
+
+// top three rows of an affine matrix, all the kernel reads
+struct Affine {
+    float m[12];
+};
+
+static Affine ToAffine(const aiMatrix4x4& a)
+{
+    return { { a.a1, a.a2, a.a3, a.a4, a.b1, a.b2, a.b3, a.b4, a.c1, a.c2, a.c3, a.c4 } };
+}
+
+struct SkinJob {
+    const float* positions = nullptr;
+    const float* normals = nullptr;
+    const float* weights = nullptr; // bone major, weights[b * vertexCount + v], null = rigid
+    size_t vertexCount = 0;
+    std::vector<Affine> bones;      // pose * inverse bind * mesh bind per weight row
+    Affine rigid;                   // pose of the mesh node, for rigid submeshes and vertices with no weight
+    float* outPositions = nullptr;
+    float* outNormals = nullptr;
+};
+
+struct SkinChunk {
+    size_t job;
+    size_t begin;
+    size_t end;
+};
+
+// vertices per work item, big enough that handing them out costs nothing next to the maths
+static const size_t chunkVertices = 4096;
+
+static void TransformRigid(const SkinJob& job, size_t begin, size_t end)
+{
+    const float* m = job.rigid.m;
+    for (size_t v = begin; v < end; ++v) {
+        const float* p = job.positions + v * 3;
+        float* o = job.outPositions + v * 3;
+        o[0] = m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3];
+        o[1] = m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7];
+        o[2] = m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11];
+    }
+    if (!job.normals) return;
+    for (size_t v = begin; v < end; ++v) {
+        const float* n = job.normals + v * 3;
+        float* o = job.outNormals + v * 3;
+        o[0] = m[0] * n[0] + m[1] * n[1] + m[2] * n[2];
+        o[1] = m[4] * n[0] + m[5] * n[1] + m[6] * n[2];
+        o[2] = m[8] * n[0] + m[9] * n[1] + m[10] * n[2];
+    }
+}
+
+static void SkinRange(const SkinJob& job, size_t begin, size_t end, std::vector<float>& weightSum)
+{
+    if (!job.weights) {
+        TransformRigid(job, begin, end);
+        return;
+    }
+
+    size_t count = end - begin;
+    weightSum.assign(count, 0.f);
+    std::fill(job.outPositions + begin * 3, job.outPositions + end * 3, 0.f);
+    if (job.normals) std::fill(job.outNormals + begin * 3, job.outNormals + end * 3, 0.f);
+
+    // bone major like the weights are stored, every inner loop is a branch free multiply add over a contiguous range
+    for (size_t b = 0; b < job.bones.size(); ++b) {
+        const float* m = job.bones[b].m;
+        const float* w = job.weights + b * job.vertexCount;
+        for (size_t v = begin; v < end; ++v) {
+            float weight = w[v];
+            const float* p = job.positions + v * 3;
+            float* o = job.outPositions + v * 3;
+            o[0] += weight * (m[0] * p[0] + m[1] * p[1] + m[2] * p[2] + m[3]);
+            o[1] += weight * (m[4] * p[0] + m[5] * p[1] + m[6] * p[2] + m[7]);
+            o[2] += weight * (m[8] * p[0] + m[9] * p[1] + m[10] * p[2] + m[11]);
+            weightSum[v - begin] += weight;
+        }
+        if (!job.normals) continue;
+        for (size_t v = begin; v < end; ++v) {
+            float weight = w[v];
+            const float* n = job.normals + v * 3;
+            float* o = job.outNormals + v * 3;
+            o[0] += weight * (m[0] * n[0] + m[1] * n[1] + m[2] * n[2]);
+            o[1] += weight * (m[4] * n[0] + m[5] * n[1] + m[6] * n[2]);
+            o[2] += weight * (m[8] * n[0] + m[9] * n[1] + m[10] * n[2]);
+        }
+    }
+
+    // weights don't always add up to 1, and a vertex nothing holds stays with the mesh node
+    for (size_t v = begin; v < end; ++v) {
+        float sum = weightSum[v - begin];
+        if (sum <= 1e-6f) {
+            TransformRigid(job, v, v + 1);
+        }
+        else if (std::fabs(sum - 1.f) > 1e-4f) {
+            float* o = job.outPositions + v * 3;
+            o[0] /= sum; o[1] /= sum; o[2] /= sum;
+        }
+    }
+    if (!job.normals) return;
+    for (size_t v = begin; v < end; ++v) {
+        float* o = job.outNormals + v * 3;
+        float length = std::sqrt(o[0] * o[0] + o[1] * o[1] + o[2] * o[2]);
+        if (length > 0.f) {
+            o[0] /= length; o[1] /= length; o[2] /= length;
+        }
+    }
+}
+
+std::vector<aiMatrix4x4> ModelBindWorldMatrices(const MKDXData& model)
+{
+    // a clip with no bones leaves every node at its rest transform
+    MotPoseBinding binding = BindMotToModel(MotData(), model);
+    std::vector<aiMatrix4x4> world;
+    ComposeWorldMatrices(binding, {}, world);
+    return world;
+}
+
+void SkinModel(const MKDXData& model, const std::vector<aiMatrix4x4>& bindWorld, const std::vector<aiMatrix4x4>& poseWorld,
+    std::vector<SkinnedSubMesh>& out, unsigned int threadCount)
+{
+    PROFILE_SCOPE("SkinModel");
+
+    // inverse bind of each node, only worked out for nodes something is skinned to
+    std::vector<aiMatrix4x4> inverseBind(bindWorld.size());
+    std::vector<uint8_t> haveInverse(bindWorld.size(), 0);
+
+    std::vector<SkinJob> jobs;
+    size_t outIndex = 0;
+    for (uint32_t nodeIndex = 0; nodeIndex < model.fullNodeDataList.size(); ++nodeIndex) {
+        const FullNodeData& nodeData = model.fullNodeDataList[nodeIndex];
+        if (nodeData.subMeshes.empty()) continue;
+
+        const NodeLinks* link = nullptr;
+        for (const auto& l : model.nodeLinks)
+            if (l.MeshOffset == nodeIndex) link = &l;
+
+        for (uint32_t s = 0; s < nodeData.subMeshes.size() && s < nodeData.verticesList.size(); ++s) {
+            const SubMesh& sub = nodeData.subMeshes[s];
+            if (outIndex >= out.size()) out.emplace_back();
+            SkinnedSubMesh& skinned = out[outIndex++];
+            skinned.node = nodeIndex;
+            skinned.subMesh = s;
+
+            SkinJob job;
+            job.vertexCount = sub.VertexCount;
+            job.positions = nodeData.verticesList[s].data();
+            job.normals = s < nodeData.normalsList.size() ? nodeData.normalsList[s].data() : nullptr;
+            job.rigid = ToAffine(poseWorld[nodeIndex]);
+            skinned.positions.resize(job.vertexCount * 3);
+            skinned.normals.resize(job.normals ? job.vertexCount * 3 : 0);
+
+            if (sub.SkinnedBonesCount && link && s < nodeData.weightsList.size()) {
+                for (uint32_t i = 0; i < link->BoneOffsets.size() && i < 32; ++i) {
+                    if (!(sub.BonesIndexMask & (1u << i))) continue;
+                    uint32_t bone = link->BoneOffsets[i];
+                    if (!haveInverse[bone]) {
+                        inverseBind[bone] = bindWorld[bone];
+                        inverseBind[bone].Inverse();
+                        haveInverse[bone] = 1;
+                    }
+                    job.bones.push_back(ToAffine(poseWorld[bone] * inverseBind[bone] * bindWorld[nodeIndex]));
+                }
+                if (!job.bones.empty() && nodeData.weightsList[s].size() >= job.bones.size() * job.vertexCount)
+                    job.weights = nodeData.weightsList[s].data();
+            }
+            jobs.push_back(std::move(job));
+        }
+    }
+    out.resize(outIndex);
+
+    // jobs hold raw pointers into out, set them once it has stopped growing
+    std::vector<SkinChunk> chunks;
+    for (size_t j = 0; j < jobs.size(); ++j) {
+        jobs[j].outPositions = out[j].positions.data();
+        jobs[j].outNormals = out[j].normals.data();
+        for (size_t begin = 0; begin < jobs[j].vertexCount; begin += chunkVertices)
+            chunks.push_back({ j, begin, std::min(begin + chunkVertices, jobs[j].vertexCount) });
+    }
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = static_cast<unsigned int>(std::min<size_t>(threadCount, chunks.size()));
+
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+        std::vector<float> weightSum;
+        for (size_t c = nextChunk++; c < chunks.size(); c = nextChunk++)
+            SkinRange(jobs[chunks[c].job], chunks[c].begin, chunks[c].end, weightSum);
+    };
+
+    if (threadCount <= 1) {
+        worker();
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int t = 1; t < threadCount; ++t)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads) thread.join();
+}
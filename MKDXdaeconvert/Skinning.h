@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <assimp/matrix4x4.h>
+#include "CoolStructs.h"
+
+// one submesh deformed by a pose, xyz per vertex in model space
+struct SkinnedSubMesh {
+    uint32_t node = 0;
+    uint32_t subMesh = 0;
+    std::vector<float> positions;
+    std::vector<float> normals; // empty if the submesh has none
+};
+
+// world matrix of every node at the model's own BoneData transforms, the pose the weights were made against
+std::vector<aiMatrix4x4> ModelBindWorldMatrices(const MKDXData& model);
+
+// linear blend skinning of every submesh of the model, poseWorld is one world matrix per node (ComposeWorldMatrices)
+// weights are the dense per submesh SkinnedBonesCount x VertexCount block, bones picked out of the node's NodeLinks by
+// BonesIndexMask, submeshes without weights just follow their node, out is reused between calls so sampling many
+// frames doesn't reallocate, threadCount 0 = one per core
+void SkinModel(const MKDXData& model, const std::vector<aiMatrix4x4>& bindWorld, const std::vector<aiMatrix4x4>& poseWorld,
+    std::vector<SkinnedSubMesh>& out, unsigned int threadCount = 0);
@@ -0,0 +1,659 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "StreamDae.h"
+#include "SaveFuncs.h"
+#include "ContentHash.h"
+#include "Skinning.h"
+#include "AnimEval.h"
+#include "Profiler.h"
+
+// text is built up here and handed to the stream in big blocks, numbers are formatted straight into it
+class DaeWriter {
+public:
+    explicit DaeWriter(std::ostream& out) : out(out) { buffer.reserve(flushSize + 1024); }
+    ~DaeWriter() { Flush(); }
+
+    DaeWriter& operator<<(const char* text) { buffer += text; return MaybeFlush(); }
+    DaeWriter& operator<<(const std::string& text) { buffer += text; return MaybeFlush(); }
+    DaeWriter& operator<<(size_t value) {
+        char number[32];
+        int length = snprintf(number, sizeof(number), "%zu", value);
+        buffer.append(number, length);
+        return MaybeFlush();
+    }
+
+    // %.9g is enough digits for a float to read back as the same float
+    void Floats(const float* values, size_t count) {
+        char number[32];
+        for (size_t i = 0; i < count; ++i) {
+            if (i) buffer += ' ';
+            int length = snprintf(number, sizeof(number), "%.9g", values[i]);
+            buffer.append(number, length);
+            MaybeFlush();
+        }
+    }
+    void Ints(const uint32_t* values, size_t count) {
+        char number[16];
+        for (size_t i = 0; i < count; ++i) {
+            if (i) buffer += ' ';
+            int length = snprintf(number, sizeof(number), "%u", values[i]);
+            buffer.append(number, length);
+            MaybeFlush();
+        }
+    }
+    void Matrix(const aiMatrix4x4& m) {
+        // collada matrices are row major like assimp's
+        Floats(&m.a1, 16);
+    }
+
+    void Flush() {
+        out.write(buffer.data(), buffer.size());
+        buffer.clear();
+    }
+
+private:
+    static const size_t flushSize = 1 << 16;
+
+    DaeWriter& MaybeFlush() {
+        if (buffer.size() >= flushSize) Flush();
+        return *this;
+    }
+
+    std::ostream& out;
+    std::string buffer;
+};
+
+static std::string XmlEscape(const std::string& text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+        switch (c) {
+        case '&': escaped += "&amp;"; break;
+        case '<': escaped += "&lt;"; break;
+        case '>': escaped += "&gt;"; break;
+        case '"': escaped += "&quot;"; break;
+        case '\'': escaped += "&apos;"; break;
+        default: escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// node names as xml ids/sids, anything that isn't a name character becomes _ and repeats get the node index added
+static std::vector<std::string> MakeNodeIds(const std::vector<NodeNames>& allNodeNames)
+{
+    std::vector<std::string> ids(allNodeNames.size());
+    std::unordered_set<std::string> used = { "Scene", "Armature" };
+    for (size_t i = 0; i < allNodeNames.size(); ++i) {
+        std::string id = allNodeNames[i].Name;
+        for (char& c : id) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '_' && c != '-' && c != '.') c = '_';
+        }
+        if (id.empty() || !(isalpha(static_cast<unsigned char>(id[0])) || id[0] == '_')) id = "_" + id;
+        if (!used.insert(id).second) {
+            id += "_" + std::to_string(i);
+            used.insert(id);
+        }
+        ids[i] = id;
+    }
+    return ids;
+}
+
+// submeshes that end up as one collada geometry, all of a node's when merging or one each
+struct MeshUnit {
+    uint32_t first;
+    uint32_t last;
+};
+
+// what the visual scene needs to instance a written geometry/controller on its node
+struct MeshInstance {
+    std::string url;
+    bool skinned;
+    std::vector<uint32_t> materials;
+};
+
+static void WriteMaterialLibraries(DaeWriter& w, const std::vector<Material>& materialsData, const std::vector<TextureName>& textureNames)
+{
+    if (!textureNames.empty()) {
+        w << "  <library_images>\n";
+        for (size_t t = 0; t < textureNames.size(); ++t) {
+            w << "    <image id=\"texture_" << t << "\" name=\"" << XmlEscape(textureNames[t].Name) << "\">\n"
+              << "      <init_from>" << XmlEscape(textureNames[t].Name) << "</init_from>\n"
+              << "    </image>\n";
+        }
+        w << "  </library_images>\n";
+    }
+
+    // same slots BuildExportScene fills in, diffuse/specular/reflective as phong textures and normals as a bump extra
+    w << "  <library_effects>\n";
+    for (size_t i = 0; i < materialsData.size(); ++i) {
+        const std::vector<int16_t>& tex = materialsData[i].TextureIndices;
+        auto textureAt = [&](size_t slot) -> int {
+            return slot < tex.size() && tex[slot] >= 0 && tex[slot] < static_cast<int>(textureNames.size()) ? tex[slot] : -1;
+        };
+        const size_t slots[] = { 0, 1, 2, 4 };
+
+        w << "    <effect id=\"material_" << i << "-fx\">\n      <profile_COMMON>\n";
+        std::unordered_set<int> declared;
+        for (size_t slot : slots) {
+            int t = textureAt(slot);
+            if (t < 0 || !declared.insert(t).second) continue;
+            std::string image = "texture_" + std::to_string(t);
+            w << "        <newparam sid=\"" << image << "-surface\"><surface type=\"2D\"><init_from>" << image << "</init_from></surface></newparam>\n"
+              << "        <newparam sid=\"" << image << "-sampler\"><sampler2D><source>" << image << "-surface</source></sampler2D></newparam>\n";
+        }
+        auto textureParam = [&](const char* element, size_t slot) {
+            int t = textureAt(slot);
+            if (t < 0) return;
+            w << "            <" << element << "><texture texture=\"texture_" << static_cast<size_t>(t) << "-sampler\" texcoord=\"CHANNEL0\"/></" << element << ">\n";
+        };
+        w << "        <technique sid=\"common\">\n          <phong>\n"
+          << "            <ambient><color sid=\"ambient\">0.5 0.5 0.5 1</color></ambient>\n";
+        textureParam("diffuse", 0);
+        textureParam("specular", 1);
+        textureParam("reflective", 2);
+        w << "          </phong>\n";
+        if (textureAt(4) >= 0) {
+            w << "          <extra><technique profile=\"FCOLLADA\">\n";
+            textureParam("bump", 4);
+            w << "          </technique></extra>\n";
+        }
+        w << "        </technique>\n      </profile_COMMON>\n    </effect>\n";
+    }
+    w << "  </library_effects>\n";
+
+    w << "  <library_materials>\n";
+    for (size_t i = 0; i < materialsData.size(); ++i)
+        w << "    <material id=\"material_" << i << "\" name=\"material_" << i << "\"><instance_effect url=\"#material_" << i << "-fx\"/></material>\n";
+    w << "  </library_materials>\n";
+}
+
+// one per vertex attribute, submeshes missing the buffer are padded with fill so every source lines up with the positions
+static void WriteSource(DaeWriter& w, const std::string& id, const FullNodeData& nodeData, const MeshUnit& unit,
+    const std::vector<std::vector<float>>& list, const std::vector<std::vector<float>>* fallback,
+    size_t components, float fill, const char* params)
+{
+    size_t vertexCount = 0;
+    for (uint32_t s = unit.first; s < unit.last; ++s) vertexCount += nodeData.subMeshes[s].VertexCount;
+
+    w << "        <source id=\"" << id << "\">\n          <float_array id=\"" << id << "-array\" count=\"" << vertexCount * components << "\">";
+    std::vector<float> padding;
+    for (uint32_t s = unit.first; s < unit.last; ++s) {
+        const std::vector<float>* data = s < list.size() ? &list[s] : (fallback && s < fallback->size() ? &(*fallback)[s] : nullptr);
+        size_t wanted = nodeData.subMeshes[s].VertexCount * components;
+        size_t have = data ? std::min(data->size(), wanted) : 0;
+        if (s != unit.first) w << " ";
+        if (have) w.Floats(data->data(), have);
+        if (have < wanted) {
+            padding.assign(wanted - have, fill);
+            if (have) w << " ";
+            w.Floats(padding.data(), padding.size());
+        }
+    }
+    w << "</float_array>\n          <technique_common>\n            <accessor source=\"#" << id << "-array\" count=\"" << vertexCount
+      << "\" stride=\"" << components << "\">" << params << "</accessor>\n          </technique_common>\n        </source>\n";
+}
+
+// submesh s's buffer with exactly VertexCount * components floats, the same values WriteSource writes for it
+static std::vector<float> SubMeshBuffer(const FullNodeData& nodeData, uint32_t s, const std::vector<std::vector<float>>& list,
+    const std::vector<std::vector<float>>* fallback, size_t components, float fill)
+{
+    const std::vector<float>* data = s < list.size() ? &list[s] : (fallback && s < fallback->size() ? &(*fallback)[s] : nullptr);
+    std::vector<float> buffer(nodeData.subMeshes[s].VertexCount * components, fill);
+    if (data) std::copy(data->begin(), data->begin() + std::min(data->size(), buffer.size()), buffer.begin());
+    return buffer;
+}
+
+// PatchDaeFile_C's vertex merge: a vertex with the same position and normal (within 1e-5) as a lower numbered one
+// points at that one's canonical vertex, candidates come from a grid of 1e-5 cells instead of the patch's all pairs
+static void WeldVertices(const std::vector<float>& positions, const std::vector<float>& normals, std::vector<uint32_t>& canonical)
+{
+    const float tolerance = 1e-5f;
+    size_t vertexCount = positions.size() / 3;
+    canonical.resize(vertexCount);
+
+    auto cellOf = [&](size_t v, int64_t cell[3]) {
+        for (int a = 0; a < 3; ++a) {
+            float p = positions[v * 3 + a];
+            if (!std::isfinite(p) || std::fabs(p) > 1e12f) return false;
+            cell[a] = static_cast<int64_t>(std::floor(p / tolerance));
+        }
+        return true;
+    };
+    auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+        uint64_t key = static_cast<uint64_t>(x) * 0x9E3779B97F4A7C15ull;
+        key ^= static_cast<uint64_t>(y) * 0xC2B2AE3D27D4EB4Full + (key << 6) + (key >> 2);
+        return key ^ (static_cast<uint64_t>(z) * 0x165667B19E3779F9ull + (key << 6) + (key >> 2));
+    };
+    auto close = [&](const std::vector<float>& values, size_t i, size_t j) {
+        for (int a = 0; a < 3; ++a)
+            if (std::fabs(values[i * 3 + a] - values[j * 3 + a]) > tolerance) return false;
+        return true;
+    };
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> grid;
+    for (size_t j = 0; j < vertexCount; ++j) {
+        canonical[j] = static_cast<uint32_t>(j);
+        int64_t cell[3];
+        if (!cellOf(j, cell)) continue;
+
+        size_t lowest = j;
+        for (int64_t dx = -1; dx <= 1; ++dx) for (int64_t dy = -1; dy <= 1; ++dy) for (int64_t dz = -1; dz <= 1; ++dz) {
+            auto it = grid.find(cellKey(cell[0] + dx, cell[1] + dy, cell[2] + dz));
+            if (it == grid.end()) continue;
+            for (uint32_t i : it->second)
+                if (i < lowest && close(positions, i, j) && close(normals, i, j)) lowest = i;
+        }
+        canonical[j] = canonical[lowest];
+        grid[cellKey(cell[0], cell[1], cell[2])].push_back(static_cast<uint32_t>(j));
+    }
+}
+
+// written the way PatchDaeFile_C leaves an assimp geometry: colours and uvs on offset 1 with each <p> entry doubled,
+// offset 0 (position + normal) welded, so the streamed .dae imports the same as a normal export
+static void WriteGeometry(DaeWriter& w, const std::string& id, const std::string& name, const FullNodeData& nodeData, const MeshUnit& unit)
+{
+    // a buffer is written if any submesh of the unit has it, same as BuildMergedMesh
+    auto anyHas = [&](const std::vector<std::vector<float>>& list) { return list.size() > unit.first; };
+    const std::vector<std::vector<float>>* uvLists[4] = { &nodeData.uvs0List, &nodeData.uvs1List, &nodeData.uvs2List, &nodeData.uvs3List };
+    static const char* xyz = "<param name=\"X\" type=\"float\"/><param name=\"Y\" type=\"float\"/><param name=\"Z\" type=\"float\"/>";
+    static const char* rgba = "<param name=\"R\" type=\"float\"/><param name=\"G\" type=\"float\"/><param name=\"B\" type=\"float\"/><param name=\"A\" type=\"float\"/>";
+    static const char* st = "<param name=\"S\" type=\"float\"/><param name=\"T\" type=\"float\"/>";
+
+    w << "    <geometry id=\"" << id << "\" name=\"" << name << "\">\n      <mesh>\n";
+    WriteSource(w, id + "-positions", nodeData, unit, nodeData.verticesList, nullptr, 3, 0.f, xyz);
+    // no normals exports the positions, like the scene path does
+    WriteSource(w, id + "-normals", nodeData, unit, nodeData.normalsList, &nodeData.verticesList, 3, 0.f, xyz);
+    bool hasColors = anyHas(nodeData.colorsList);
+    if (hasColors) WriteSource(w, id + "-colors", nodeData, unit, nodeData.colorsList, nullptr, 4, 1.f, rgba);
+    bool hasUvs[4];
+    for (int u = 0; u < 4; ++u) {
+        hasUvs[u] = anyHas(*uvLists[u]);
+        if (hasUvs[u]) WriteSource(w, id + "-uv" + std::to_string(u), nodeData, unit, *uvLists[u], nullptr, 2, 0.f, st);
+    }
+    w << "        <vertices id=\"" << id << "-vertices\"><input semantic=\"POSITION\" source=\"#" << id << "-positions\"/></vertices>\n";
+
+    // only the patch's second offset when something sits on it, like the patch only doubling <p> then
+    bool twoOffsets = hasColors || hasUvs[0] || hasUvs[1] || hasUvs[2] || hasUvs[3];
+    std::vector<uint32_t> indices, canonical;
+    uint32_t vertexBase = 0;
+    for (uint32_t s = unit.first; s < unit.last; ++s) {
+        const SubMesh& sub = nodeData.subMeshes[s];
+        // submeshes own separate vertex ranges and the patch welds per <triangles>, so per submesh is the same thing
+        WeldVertices(SubMeshBuffer(nodeData, s, nodeData.verticesList, nullptr, 3, 0.f),
+            SubMeshBuffer(nodeData, s, nodeData.normalsList, &nodeData.verticesList, 3, 0.f), canonical);
+
+        indices.clear();
+        size_t triangles = 0;
+        if (s < nodeData.polygonsList.size()) {
+            const std::vector<uint16_t>& polys = nodeData.polygonsList[s];
+            size_t count = polys.size() - polys.size() % 3;
+            triangles = count / 3;
+            indices.reserve(twoOffsets ? count * 2 : count);
+            for (size_t i = 0; i < count; ++i) {
+                uint32_t v = polys[i];
+                indices.push_back(vertexBase + (v < canonical.size() ? canonical[v] : v));
+                if (twoOffsets) indices.push_back(vertexBase + v);
+            }
+        }
+
+        w << "        <triangles material=\"material_" << static_cast<size_t>(sub.MaterialIndex) << "\" count=\"" << triangles << "\">\n"
+          << "          <input semantic=\"VERTEX\" source=\"#" << id << "-vertices\" offset=\"0\"/>\n"
+          << "          <input semantic=\"NORMAL\" source=\"#" << id << "-normals\" offset=\"0\"/>\n";
+        if (hasColors) w << "          <input semantic=\"COLOR\" source=\"#" << id << "-colors\" offset=\"1\" set=\"0\"/>\n";
+        for (int u = 0; u < 4; ++u)
+            if (hasUvs[u]) w << "          <input semantic=\"TEXCOORD\" source=\"#" << id << "-uv" << static_cast<size_t>(u) << "\" offset=\"1\" set=\"" << static_cast<size_t>(u) << "\"/>\n";
+        w << "          <p>";
+        w.Ints(indices.data(), indices.size());
+        w << "</p>\n        </triangles>\n";
+        vertexBase += sub.VertexCount;
+    }
+    w << "      </mesh>\n    </geometry>\n";
+}
+
+// skin of one unit, joints are the node's deduped BoneOffsets like the scene path and the dense bone major weights
+// go out vertex major with the zeros dropped, bind shape is identity so the inverse binds carry the mesh's world
+static void WriteController(DaeWriter& w, const std::string& id, const std::string& geometryId, const std::string& name,
+    const FullNodeData& nodeData, const MeshUnit& unit, const NodeLinks& link, const std::vector<std::string>& nodeIds,
+    const std::vector<aiMatrix4x4>& bindWorld, uint32_t meshNode)
+{
+    std::vector<uint32_t> joints;
+    std::unordered_map<uint32_t, uint32_t> jointIndex;
+    for (uint32_t bone : link.BoneOffsets)
+        if (jointIndex.emplace(bone, static_cast<uint32_t>(joints.size())).second) joints.push_back(bone);
+
+    std::vector<uint32_t> vcount, v;
+    std::vector<float> weights;
+    std::vector<uint32_t> filtered;
+    for (uint32_t s = unit.first; s < unit.last; ++s) {
+        const SubMesh& sub = nodeData.subMeshes[s];
+        size_t vertexCount = sub.VertexCount;
+
+        filtered.clear();
+        if (sub.SkinnedBonesCount) {
+            for (uint32_t i = 0; i < link.BoneOffsets.size() && i < 32; ++i)
+                if (sub.BonesIndexMask & (1u << i)) filtered.push_back(jointIndex[link.BoneOffsets[i]]);
+        }
+        const float* dense = nullptr;
+        if (!filtered.empty() && s < nodeData.weightsList.size() && nodeData.weightsList[s].size() >= filtered.size() * vertexCount)
+            dense = nodeData.weightsList[s].data();
+
+        for (size_t vert = 0; vert < vertexCount; ++vert) {
+            uint32_t influences = 0;
+            for (size_t b = 0; dense && b < filtered.size(); ++b) {
+                float weight = dense[b * vertexCount + vert];
+                if (weight <= 0.0f) continue;
+                v.push_back(filtered[b]);
+                v.push_back(static_cast<uint32_t>(weights.size()));
+                weights.push_back(weight);
+                influences++;
+            }
+            vcount.push_back(influences);
+        }
+    }
+
+    std::vector<float> inverseBinds(joints.size() * 16);
+    for (size_t j = 0; j < joints.size(); ++j) {
+        aiMatrix4x4 inverse = bindWorld[joints[j]];
+        inverse.Inverse();
+        aiMatrix4x4 m = inverse * bindWorld[meshNode];
+        std::copy(&m.a1, &m.a1 + 16, &inverseBinds[j * 16]);
+    }
+
+    w << "    <controller id=\"" << id << "\" name=\"" << name << "\">\n      <skin source=\"#" << geometryId << "\">\n"
+      << "        <bind_shape_matrix>1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1</bind_shape_matrix>\n"
+      << "        <source id=\"" << id << "-joints\">\n          <Name_array id=\"" << id << "-joints-array\" count=\"" << joints.size() << "\">";
+    for (size_t j = 0; j < joints.size(); ++j) w << (j ? " " : "") << nodeIds[joints[j]];
+    w << "</Name_array>\n          <technique_common><accessor source=\"#" << id << "-joints-array\" count=\"" << joints.size()
+      << "\" stride=\"1\"><param name=\"JOINT\" type=\"name\"/></accessor></technique_common>\n        </source>\n"
+      << "        <source id=\"" << id << "-bind_poses\">\n          <float_array id=\"" << id << "-bind_poses-array\" count=\"" << inverseBinds.size() << "\">";
+    w.Floats(inverseBinds.data(), inverseBinds.size());
+    w << "</float_array>\n          <technique_common><accessor source=\"#" << id << "-bind_poses-array\" count=\"" << joints.size()
+      << "\" stride=\"16\"><param name=\"TRANSFORM\" type=\"float4x4\"/></accessor></technique_common>\n        </source>\n"
+      << "        <source id=\"" << id << "-weights\">\n          <float_array id=\"" << id << "-weights-array\" count=\"" << weights.size() << "\">";
+    w.Floats(weights.data(), weights.size());
+    w << "</float_array>\n          <technique_common><accessor source=\"#" << id << "-weights-array\" count=\"" << weights.size()
+      << "\" stride=\"1\"><param name=\"WEIGHT\" type=\"float\"/></accessor></technique_common>\n        </source>\n"
+      << "        <joints>\n          <input semantic=\"JOINT\" source=\"#" << id << "-joints\"/>\n"
+      << "          <input semantic=\"INV_BIND_MATRIX\" source=\"#" << id << "-bind_poses\"/>\n        </joints>\n"
+      << "        <vertex_weights count=\"" << vcount.size() << "\">\n"
+      << "          <input semantic=\"JOINT\" source=\"#" << id << "-joints\" offset=\"0\"/>\n"
+      << "          <input semantic=\"WEIGHT\" source=\"#" << id << "-weights\" offset=\"1\"/>\n          <vcount>";
+    w.Ints(vcount.data(), vcount.size());
+    w << "</vcount>\n          <v>";
+    w.Ints(v.data(), v.size());
+    w << "</v>\n        </vertex_weights>\n      </skin>\n    </controller>\n";
+}
+
+static void WriteSceneNode(DaeWriter& w, uint32_t index, const MKDXData& layout, const std::vector<std::string>& nodeIds,
+    const std::vector<uint8_t>& isJoint, const std::vector<aiMatrix4x4>& restLocal,
+    const std::vector<std::vector<MeshInstance>>& instances, size_t depth, StreamDaeReport& report)
+{
+    std::string indent(depth * 2, ' ');
+    const std::string& id = nodeIds[index];
+    report.nodes++;
+
+    w << indent << "<node id=\"" << id << "\" sid=\"" << id << "\" name=\"" << XmlEscape(layout.allNodeNames[index].Name)
+      << "\" type=\"" << (isJoint[index] ? "JOINT" : "NODE") << "\">\n"
+      << indent << "  <matrix sid=\"matrix\">";
+    w.Matrix(restLocal[index]);
+    w << "</matrix>\n";
+
+    for (const MeshInstance& instance : instances[index]) {
+        const char* element = instance.skinned ? "instance_controller" : "instance_geometry";
+        w << indent << "  <" << element << " url=\"#" << instance.url << "\">\n";
+        if (instance.skinned) w << indent << "    <skeleton>#Armature</skeleton>\n";
+        w << indent << "    <bind_material><technique_common>\n";
+        for (uint32_t m : instance.materials) {
+            w << indent << "      <instance_material symbol=\"material_" << static_cast<size_t>(m) << "\" target=\"#material_" << static_cast<size_t>(m) << "\">"
+              << "<bind_vertex_input semantic=\"CHANNEL0\" input_semantic=\"TEXCOORD\" input_set=\"0\"/></instance_material>\n";
+        }
+        w << indent << "    </technique_common></bind_material>\n" << indent << "  </" << element << ">\n";
+    }
+
+    for (uint32_t child : layout.fullNodeDataList[index].childrenIndexList)
+        WriteSceneNode(w, child, layout, nodeIds, isJoint, restLocal, instances, depth + 1, report);
+    w << indent << "</node>\n";
+}
+
+void StreamDaeFile(const std::string& path, const std::string& outDir, std::istream& fs, MKDXData& layout,
+    const bool mergeSubmeshes, StreamDaeReport& report, IOStats* stats, NormalsSidecar* normals)
+{
+    PROFILE_SCOPE("StreamDaeFile");
+    std::string outFile = MakeOutFilePath(path.substr(0, path.find_last_of('.')) + "_out", outDir) + ".dae";
+    std::string controllersFile = outFile + ".controllers.tmp";
+
+    std::ofstream out(outFile, std::ios::binary);
+    if (!out) throw std::runtime_error("couldn't write " + outFile);
+    // controllers go to their own file while the geometries stream so each library comes out in one piece
+    std::ofstream controllersOut(controllersFile, std::ios::binary);
+    if (!controllersOut) throw std::runtime_error("couldn't write " + controllersFile);
+
+    size_t nodeCount = layout.fullNodeDataList.size();
+    std::vector<std::string> nodeIds = MakeNodeIds(layout.allNodeNames);
+    std::vector<aiMatrix4x4> bindWorld = ModelBindWorldMatrices(layout);
+    MotPoseBinding rest = BindMotToModel(MotData(), layout);
+
+    // bones and everything above them are joints, the scene path gets the same from adding every used bone's parents
+    std::vector<uint8_t> isJoint(nodeCount, 0);
+    for (const NodeLinks& link : layout.nodeLinks) {
+        for (uint32_t bone : link.BoneOffsets) {
+            for (int32_t n = static_cast<int32_t>(bone); n >= 0 && !isJoint[n]; n = rest.parents[n])
+                isJoint[n] = 1;
+        }
+    }
+
+    std::vector<const NodeLinks*> nodeLink(nodeCount, nullptr);
+    for (const NodeLinks& link : layout.nodeLinks)
+        if (link.MeshOffset < nodeCount) nodeLink[link.MeshOffset] = &link;
+
+    // hierarchy order, same walk the visual scene does
+    std::vector<uint32_t> order;
+    std::vector<uint8_t> visited(nodeCount, 0);
+    std::vector<uint32_t> stack(layout.rootNodes.rbegin(), layout.rootNodes.rend());
+    while (!stack.empty()) {
+        uint32_t n = stack.back();
+        stack.pop_back();
+        if (n >= nodeCount || visited[n]) continue;
+        visited[n] = 1;
+        order.push_back(n);
+        const std::vector<uint32_t>& children = layout.fullNodeDataList[n].childrenIndexList;
+        stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+
+    DaeWriter w(out);
+    w << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+      << "<COLLADA xmlns=\"http://www.collada.org/2005/11/COLLADASchema\" version=\"1.4.1\">\n"
+      << "  <asset>\n    <contributor><authoring_tool>MKDXTool</authoring_tool></contributor>\n"
+      << "    <unit name=\"meter\" meter=\"1\"/>\n    <up_axis>Y_UP</up_axis>\n  </asset>\n";
+    WriteMaterialLibraries(w, layout.materialsData, layout.textureNames);
+
+    ProfileScope nodesStage("stream nodes");
+    DaeWriter controllers(controllersOut);
+    std::vector<std::vector<MeshInstance>> instances(nodeCount);
+    // unskinned units already written are instanced instead of written again, earlier buffers are gone by then so a
+    // match needs the content hash, a second unrelated hash and the byte count to all agree
+    struct WrittenGeometry {
+        uint64_t check;
+        size_t bytes;
+        std::string id;
+    };
+    std::unordered_map<uint64_t, std::vector<WrittenGeometry>> geometryByContent;
+    GeometryNamer geometryNames;
+    w << "  <library_geometries>\n";
+    for (uint32_t n : order) {
+        FullNodeData& nodeData = layout.fullNodeDataList[n];
+        if (nodeData.subMeshes.empty()) continue;
+
+        {
+            IOStatsScope ioStatsScope(stats);
+            LoadNodeBuffers(fs, nodeData);
+        }
+        size_t nodeBytes = 0;
+        for (const auto* list : { &nodeData.verticesList, &nodeData.normalsList, &nodeData.colorsList, &nodeData.uvs0List,
+            &nodeData.uvs1List, &nodeData.uvs2List, &nodeData.uvs3List, &nodeData.weightsList })
+            for (const auto& buffer : *list) nodeBytes += buffer.size() * sizeof(float);
+        for (const auto& buffer : nodeData.polygonsList) nodeBytes += buffer.size() * sizeof(uint16_t);
+        report.largestNodeBytes = std::max(report.largestNodeBytes, nodeBytes);
+
+        std::vector<MeshUnit> units;
+        if (mergeSubmeshes) units.push_back({ 0, static_cast<uint32_t>(nodeData.subMeshes.size()) });
+        else for (uint32_t s = 0; s < nodeData.subMeshes.size(); ++s) units.push_back({ s, s + 1 });
+
+        for (size_t u = 0; u < units.size(); ++u) {
+            const MeshUnit& unit = units[u];
+            std::string suffix = mergeSubmeshes ? std::string() : std::to_string(u);
+            std::string geometryId = nodeIds[n] + "-mesh" + suffix;
+
+            MeshInstance instance;
+            instance.skinned = false;
+            for (uint32_t s = unit.first; s < unit.last; ++s) {
+                uint32_t material = nodeData.subMeshes[s].MaterialIndex;
+                if (std::find(instance.materials.begin(), instance.materials.end(), material) == instance.materials.end())
+                    instance.materials.push_back(material);
+                instance.skinned |= nodeData.subMeshes[s].SkinnedBonesCount > 0;
+            }
+            instance.skinned &= nodeLink[n] != nullptr;
+
+            if (!nodeLink[n]) {
+                uint64_t contentHash = ContentHashSeed, check = ContentHashSeed;
+                size_t bytes = 0;
+                for (uint32_t s = unit.first; s < unit.last; ++s) {
+                    contentHash = HashSubMeshContent(nodeData, s, contentHash);
+                    check = HashSubMeshContent(nodeData, s, check, HashBytesMix);
+                    bytes += SubMeshContentBytes(nodeData, s);
+                }
+                std::vector<WrittenGeometry>& candidates = geometryByContent[contentHash];
+                auto found = std::find_if(candidates.begin(), candidates.end(),
+                    [&](const WrittenGeometry& g) { return g.check == check && g.bytes == bytes; });
+                if (found != candidates.end()) {
+                    instance.url = found->id;
+                    instances[n].push_back(std::move(instance));
+                    report.instanced++;
+                    continue;
+                }
+                candidates.push_back({ check, bytes, geometryId });
+            }
+
+            // named like the patch's rename pass would leave them, in the order they're written
+            std::string rawName = geometryNames.Next(layout.allNodeNames[n].Name);
+            std::string name = XmlEscape(rawName);
+            WriteGeometry(w, geometryId, name, nodeData, unit);
+            if (normals) {
+                // the same normals WriteGeometry just wrote, taken while this node's buffers are still loaded
+                std::vector<float> unitNormals;
+                for (uint32_t s = unit.first; s < unit.last; ++s) {
+                    std::vector<float> buffer = SubMeshBuffer(nodeData, s, nodeData.normalsList, &nodeData.verticesList, 3, 0.f);
+                    unitNormals.insert(unitNormals.end(), buffer.begin(), buffer.end());
+                }
+                normals->AddMesh(rawName, unitNormals.data(), static_cast<uint32_t>(unitNormals.size() / 3));
+            }
+            report.geometries++;
+            instance.url = geometryId;
+
+            if (instance.skinned) {
+                instance.url = nodeIds[n] + "-skin" + suffix;
+                WriteController(controllers, instance.url, geometryId, name, nodeData, unit, *nodeLink[n], nodeIds, bindWorld, n);
+                report.controllers++;
+            }
+            instances[n].push_back(std::move(instance));
+        }
+
+        FreeNodeBuffers(nodeData);
+    }
+    w << "  </library_geometries>\n";
+    nodesStage.End();
+
+    ProfileScope sceneStage("visual scene");
+    controllers.Flush();
+    controllersOut.close();
+    if (report.controllers) {
+        w << "  <library_controllers>\n";
+        w.Flush();
+        std::ifstream controllersIn(controllersFile, std::ios::binary);
+        out << controllersIn.rdbuf();
+        w << "  </library_controllers>\n";
+    }
+    remove(controllersFile.c_str());
+
+    w << "  <library_visual_scenes>\n    <visual_scene id=\"Scene\" name=\"Scene\">\n"
+      << "      <node id=\"Armature\" sid=\"Armature\" name=\"Armature\" type=\"NODE\">\n";
+    for (uint32_t root : layout.rootNodes)
+        if (root < nodeCount) WriteSceneNode(w, root, layout, nodeIds, isJoint, rest.restLocal, instances, 4, report);
+    w << "      </node>\n    </visual_scene>\n  </library_visual_scenes>\n"
+      << "  <scene><instance_visual_scene url=\"#Scene\"/></scene>\n</COLLADA>\n";
+    w.Flush();
+    if (!out) throw std::runtime_error("failed writing " + outFile);
+}
+
+void SaveDaeFileStreamed(const std::string& path, const std::string& outDir, std::istream& fs, MKDXData& layout,
+    const bool mergeSubmeshes, uint32_t formats, IOStats* stats)
+{
+    PROFILE_SCOPE("SaveDaeFileStreamed");
+    std::string basePath = MakeOutFilePath(path.substr(0, path.find_last_of('.')) + "_out", outDir);
+    std::string outFile = basePath + ".dae";
+    std::string fbxPath = basePath + ".fbx";
+    bool haveFbxTool = (formats & ExportFbx) && HaveFbxConverter();
+
+    std::ostringstream log;
+    std::vector<std::string> failed;
+
+    // the preset is only material and node info so it doesn't wait on any buffers
+    std::string presetFilename;
+    if (formats & ExportPreset) {
+        std::cout << std::endl << "Writing preset..." << std::endl;
+        WritePresetFile(MakePresetPath(path, outDir, presetFilename), layout.materialsData, layout.textureNames, layout.allNodeNames, layout.fullNodeDataList);
+    }
+
+    // the sidecar is filled by the dae stream, so asking for normals alone still streams a .dae and drops it after
+    std::unique_ptr<NormalsSidecar> normals;
+    if (formats & ExportNormals) normals.reset(new NormalsSidecar(basePath));
+
+    StreamDaeReport report;
+    if (formats & (ExportDae | ExportFbx | ExportNormals)) {
+        std::cout << std::endl << "Streaming collada .dae..." << std::endl;
+        try {
+            StreamDaeFile(path, outDir, fs, layout, mergeSubmeshes, report, stats, normals.get());
+            if (normals) normals->Finish();
+            if (haveFbxTool) RunFbxConverter(outFile, fbxPath);
+        }
+        catch (const std::exception& e) {
+            failed.push_back(std::string("collada: ") + e.what());
+            haveFbxTool = false;
+        }
+        if (!(formats & ExportDae)) remove(outFile.c_str());
+    }
+
+    if (formats & (ExportGltf | ExportGlb)) {
+        std::cout << "\n--stream doesn't write gltf/glb, they need a normal export\n";
+        log << "Skipped gltf/glb, --stream doesn't write them\n";
+    }
+    if ((formats & ExportDae) && failed.empty()) {
+        std::cout << std::endl << "Saved file as " << outFile << std::endl
+            << std::dec << report.geometries << " meshes (" << report.instanced << " more instanced), " << report.controllers << " skins, largest node held " << report.largestNodeBytes / 1024 << " KB\n";
+        log << "Saved collada file to " << outFile << "\n";
+    }
+    if ((formats & ExportNormals) && failed.empty()) {
+        std::cout << "\nMaya py script to import normals after dae import: " << basePath << "_normals.txt <- run that in script editor!\n";
+        log << "Along with Maya py script to import normals\n";
+    }
+    if (haveFbxTool) log << "\nBlender users must open created FBX imported at scale 100\n";
+    if (formats & ExportPreset) log << "\nCreated " << presetFilename + "Preset.txt" << " file for MKDX importing\n";
+    for (const std::string& f : failed) {
+        std::cerr << "Failed " << f << "\n";
+        log << "\nFailed " << f << "\n";
+    }
+    std::ofstream(logPath.c_str(), std::ios::trunc) << log.str();
+}
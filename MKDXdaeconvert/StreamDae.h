@@ -0,0 +1,30 @@
+#pragma once
+
+#include <istream>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include "CoolStructs.h"
+#include "IOStats.h"
+
+class NormalsSidecar;
+
+struct StreamDaeReport {
+    size_t nodes = 0;              // nodes in the visual scene
+    size_t geometries = 0;
+    size_t instanced = 0;          // meshes that reused an identical geometry written for an earlier node
+    size_t controllers = 0;
+    size_t largestNodeBytes = 0;   // biggest set of buffers held at once
+};
+
+// writes <stem>_out.dae straight from the .bin without building the whole model or an aiScene, layout comes from
+// LoadMKDXLayout on fs and each mesh node's buffers are read, written out and freed before the next one, normals also go
+// to the sidecar if one is given
+// the .dae comes out in the form PatchDaeFile_C leaves an assimp export in (per-submesh materials, colours/uvs on a second
+// <p> offset, welded positions, _2/_3 geometry names) so the patch dll isn't run on it
+void StreamDaeFile(const std::string& path, const std::string& outDir, std::istream& fs, MKDXData& layout,
+    const bool mergeSubmeshes, StreamDaeReport& report, IOStats* stats = nullptr, NormalsSidecar* normals = nullptr);
+
+// --stream version of SaveDaeFile, dae/fbx/normals/preset only, gltf/glb need the whole model so they're skipped
+void SaveDaeFileStreamed(const std::string& path, const std::string& outDir, std::istream& fs, MKDXData& layout,
+    const bool mergeSubmeshes, uint32_t formats = ExportDefault, IOStats* stats = nullptr);
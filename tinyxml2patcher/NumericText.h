@@ -0,0 +1,197 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define NUMERIC_TEXT_SSE2 1
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// whitespace separated arrays in COLLADA text (<p>, <v>, <vcount>, float_array, Name_array) read and written straight
+// from tinyxml2's buffers, from_chars/to_chars skip the locale and never allocate so this is what big meshes go through
+// parsing stops at the first thing that isn't a number, same as the old stream >> loops did
+
+inline bool IsTextSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+#ifdef NUMERIC_TEXT_SSE2
+// bit i set where byte i of the 16 at p is whitespace
+inline unsigned int SpaceMask16(const char* p)
+{
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i space = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+    return static_cast<unsigned int>(_mm_movemask_epi8(space));
+}
+
+inline unsigned int LowestSetBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return bit;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+inline unsigned int BitCount16(unsigned int mask)
+{
+    mask = mask - ((mask >> 1) & 0x5555u);
+    mask = (mask & 0x3333u) + ((mask >> 2) & 0x3333u);
+    mask = (mask + (mask >> 4)) & 0x0F0Fu;
+    return (mask + (mask >> 8)) & 0x1Fu;
+}
+#endif
+
+// first non whitespace at or after p, the single separator between numbers is checked before going wide
+// so only the indented runs of pretty printed files take the 16 byte path
+inline const char* SkipTextSpace(const char* p, const char* end)
+{
+    if (p < end && !IsTextSpace(*p)) return p;
+#ifdef NUMERIC_TEXT_SSE2
+    while (end - p >= 16) {
+        unsigned int notSpace = ~SpaceMask16(p) & 0xFFFFu;
+        if (notSpace) return p + LowestSetBit(notSpace);
+        p += 16;
+    }
+#endif
+    while (p < end && IsTextSpace(*p)) ++p;
+    return p;
+}
+
+inline const char* SkipToTextSpace(const char* p, const char* end)
+{
+    while (p < end && !IsTextSpace(*p)) ++p;
+    return p;
+}
+
+// tokens in text, used to size the output once before parsing
+inline size_t CountTextTokens(const char* p, const char* end)
+{
+    size_t count = 0;
+    bool prevSpace = true;
+#ifdef NUMERIC_TEXT_SSE2
+    while (end - p >= 16) {
+        unsigned int notSpace = ~SpaceMask16(p) & 0xFFFFu;
+        // a token starts wherever a non space byte follows a space byte
+        unsigned int starts = notSpace & ~((notSpace << 1) | (prevSpace ? 0u : 1u));
+        count += BitCount16(starts & 0xFFFFu);
+        prevSpace = !(notSpace & 0x8000u);
+        p += 16;
+    }
+#endif
+    for (; p < end; ++p) {
+        bool space = IsTextSpace(*p);
+        if (!space && prevSpace) count++;
+        prevSpace = space;
+    }
+    return count;
+}
+
+template <typename T>
+inline const char* ParseTextNumber(const char* p, const char* end, T& value)
+{
+    if (std::is_floating_point<T>::value && p < end && *p == '+') ++p; // from_chars won't take the sign streams did
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+// appends every number in text to out, returns how many it read
+template <typename T>
+inline size_t ParseTextNumbers(const char* text, std::vector<T>& out)
+{
+    if (!text) return 0;
+    const char* end = text + strlen(text);
+    size_t first = out.size();
+    out.resize(first + CountTextTokens(text, end));
+
+    size_t n = first;
+    for (const char* p = SkipTextSpace(text, end); p < end && n < out.size(); p = SkipTextSpace(p, end)) {
+        p = ParseTextNumber(p, end, out[n]);
+        if (!p) break;
+        n++;
+    }
+    out.resize(n);
+    return n - first;
+}
+
+// fixed size version for small arrays like a <matrix>, anything missing keeps what out already held
+template <typename T>
+inline size_t ParseTextNumbers(const char* text, T* out, size_t maxCount)
+{
+    if (!text) return 0;
+    const char* end = text + strlen(text);
+    size_t n = 0;
+    for (const char* p = SkipTextSpace(text, end); p < end && n < maxCount; p = SkipTextSpace(p, end)) {
+        T value;
+        p = ParseTextNumber(p, end, value);
+        if (!p) break;
+        out[n++] = value;
+    }
+    return n;
+}
+
+// calls fn with a string_view of every whitespace separated token, views point into text
+template <typename Fn>
+inline void ForEachTextToken(const char* text, Fn&& fn)
+{
+    if (!text) return;
+    const char* end = text + strlen(text);
+    for (const char* p = SkipTextSpace(text, end); p < end; p = SkipTextSpace(p, end)) {
+        const char* tokenEnd = SkipToTextSpace(p, end);
+        fn(std::string_view(p, static_cast<size_t>(tokenEnd - p)));
+        p = tokenEnd;
+    }
+}
+
+// integers appended space separated, with a space between them and anything already in out
+// the string grows once to the worst case and is trimmed after, no per number temporaries
+template <typename T>
+inline void AppendTextNumbers(std::string& out, const T* values, size_t count)
+{
+    static_assert(std::is_integral<T>::value, "AppendTextNumbers writes integers, use AppendTextFixed for floats");
+    if (count == 0) return;
+    const size_t maxChars = std::numeric_limits<T>::digits10 + 3; // digits, sign and the separator
+
+    size_t used = out.size();
+    out.resize(used + count * maxChars);
+    char* p = &out[0] + used;
+    char* end = &out[0] + out.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (p != out.data()) *p++ = ' ';
+        p = std::to_chars(p, end, values[i]).ptr;
+    }
+    out.resize(static_cast<size_t>(p - out.data()));
+}
+
+template <typename T>
+inline void AppendTextNumbers(std::string& out, const std::vector<T>& values)
+{
+    AppendTextNumbers(out, values.data(), values.size());
+}
+
+// floats written like std::fixed with the given precision
+inline void AppendTextFixed(std::string& out, const float* values, size_t count, int precision)
+{
+    char buffer[64];
+    for (size_t i = 0; i < count; ++i) {
+        if (!out.empty()) out += ' ';
+        std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), values[i], std::chars_format::fixed, precision);
+        if (result.ec == std::errc()) out.append(buffer, result.ptr);
+        else out += '0';
+    }
+}
@@ -12,35 +12,115 @@
 #include <stdlib.h>
 #include <array>
 #include <algorithm>
+#include "NumericText.h"
 using namespace tinyxml2;
 
-struct Vec3 {
-    float x, y, z;
-};
+// id, sid and instance url lookups for one document, built in one walk so the passes don't search the tree on every query
+// anything a pass deletes has to be Removed first and anything it inserts Added after, or the index points at freed elements
+class DaeIndex {
+public:
+    explicit DaeIndex(tinyxml2::XMLDocument& doc) {
+        if (doc.RootElement()) Add(doc.RootElement());
+    }
+
+    // element and everything under it, first one in document order wins like the old recursive searches
+    void Add(tinyxml2::XMLElement* element) {
+        if (const char* id = element->Attribute("id"))
+            ids.emplace(id, element);
 
-tinyxml2::XMLElement* FindInstance(tinyxml2::XMLElement* node, const std::string& geomUrl, const std::string& ctrlUrl) {
-    for (auto inst = node->FirstChildElement("instance_geometry"); inst; inst = inst->NextSiblingElement("instance_geometry")) {
-        const char* urlAttr = inst->Attribute("url");
-        if (urlAttr) {
-            //std::cout << "  checking instance_geometry url=" << urlAttr << "\n";
-            if (std::string(urlAttr) == geomUrl) return inst;
+        const char* name = element->Name();
+        if (strcmp(name, "node") == 0) {
+            const char* sid = element->Attribute("sid");
+            if (sid && element->Attribute("name"))
+                sids.emplace(sid, element);
         }
+        else if (strcmp(name, "instance_geometry") == 0 || strcmp(name, "instance_controller") == 0) {
+            if (const char* url = element->Attribute("url"))
+                instances[url].push_back(element);
+        }
+
+        for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement())
+            Add(child);
     }
 
-    for (auto inst = node->FirstChildElement("instance_controller"); inst; inst = inst->NextSiblingElement("instance_controller")) {
-        const char* urlAttr = inst->Attribute("url");
-        if (urlAttr) {
-            //std::cout << "  checking instance_controller url=" << urlAttr << "\n";
-            if (std::string(urlAttr) == ctrlUrl) return inst;
+    void Remove(tinyxml2::XMLElement* element) {
+        if (const char* id = element->Attribute("id"))
+            EraseIfSame(ids, id, element);
+        if (const char* sid = element->Attribute("sid"))
+            EraseIfSame(sids, sid, element);
+        if (const char* url = element->Attribute("url")) {
+            auto it = instances.find(url);
+            if (it != instances.end()) {
+                it->second.erase(std::remove(it->second.begin(), it->second.end(), element), it->second.end());
+                if (it->second.empty()) instances.erase(it);
+            }
         }
+
+        for (tinyxml2::XMLElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement())
+            Remove(child);
+    }
+
+    tinyxml2::XMLElement* FindById(const std::string& id) const {
+        auto it = ids.find(id);
+        return it == ids.end() ? nullptr : it->second;
+    }
+
+    // "#id" source/url attributes
+    tinyxml2::XMLElement* FindByUrl(const char* url) const {
+        if (!url || url[0] != '#') return nullptr;
+        return FindById(url + 1);
     }
 
-    for (auto child = node->FirstChildElement("node"); child; child = child->NextSiblingElement("node")) {
-        auto found = FindInstance(child, geomUrl, ctrlUrl);
-        if (found) return found;
+    // instance_geometrys pointing at geomUrl, or failing that the instance_controllers pointing at ctrlUrl, in document
+    // order, geometry the exporter instanced on several nodes has more than one
+    const std::vector<tinyxml2::XMLElement*>& FindInstances(const std::string& geomUrl, const std::string& ctrlUrl) const {
+        static const std::vector<tinyxml2::XMLElement*> none;
+        auto it = instances.find(geomUrl);
+        if (it == instances.end()) it = instances.find(ctrlUrl);
+        return it == instances.end() ? none : it->second;
     }
 
-    return nullptr;
+    // name of the node with this sid, empty if there isn't one
+    std::string FindNodeNameBySID(const std::string& sid) const {
+        auto it = sids.find(sid);
+        return it == sids.end() ? std::string() : it->second->Attribute("name");
+    }
+
+private:
+    static void EraseIfSame(std::unordered_map<std::string, tinyxml2::XMLElement*>& map, const char* key, tinyxml2::XMLElement* element) {
+        auto it = map.find(key);
+        if (it != map.end() && it->second == element) map.erase(it);
+    }
+
+    std::unordered_map<std::string, tinyxml2::XMLElement*> ids;
+    std::unordered_map<std::string, tinyxml2::XMLElement*> sids;
+    std::unordered_map<std::string, std::vector<tinyxml2::XMLElement*>> instances;
+};
+
+// every <polylist> becomes <triangles> where it stands, renamed with its attributes and children kept and just <vcount> dropped
+// nothing is cloned so the big <p> text is never copied, only holds for files that are already all triangles (what the exporters write)
+void ConvertPolylistsToTriangles(tinyxml2::XMLDocument& doc, DaeIndex& index)
+{
+    tinyxml2::XMLElement* collada = doc.FirstChildElement("COLLADA");
+    tinyxml2::XMLElement* libGeometries = collada ? collada->FirstChildElement("library_geometries") : nullptr;
+    if (!libGeometries) return;
+
+    for (auto geometry = libGeometries->FirstChildElement("geometry"); geometry; geometry = geometry->NextSiblingElement("geometry")) {
+        auto meshElem = geometry->FirstChildElement("mesh");
+        if (!meshElem) continue;
+
+        for (auto polylist = meshElem->FirstChildElement("polylist"); polylist;) {
+            auto next = polylist->NextSiblingElement("polylist");
+
+            polylist->SetName("triangles", true);
+            while (auto vcount = polylist->FirstChildElement("vcount")) {
+                index.Remove(vcount);
+                polylist->DeleteChild(vcount);
+            }
+
+            polylist = next;
+        }
+    }
 }
 
 bool IsMeshNode(tinyxml2::XMLElement* node)
@@ -159,12 +239,7 @@ Mat4 ParseMatrix(tinyxml2::XMLElement* node)
     Mat4 mat;
     tinyxml2::XMLElement* matElem = node->FirstChildElement("matrix");
     if (matElem && matElem->GetText())
-    {
-        std::istringstream iss(matElem->GetText());
-        for (int i = 0;i < 4;i++)
-            for (int j = 0;j < 4;j++)
-                iss >> mat.m[i][j];
-    }
+        ParseTextNumbers(matElem->GetText(), &mat.m[0][0], 16);
     return mat;
 }
 
@@ -183,20 +258,16 @@ Mat4 GetWorldMatrix(tinyxml2::XMLElement* node)
 
 std::string MatrixToString(const Mat4& mat)
 {
-    std::ostringstream oss;
-    oss.precision(9);
-    oss << std::fixed
-        << mat.m[0][0] << " " << mat.m[0][1] << " " << mat.m[0][2] << " " << mat.m[0][3] << " "
-        << mat.m[1][0] << " " << mat.m[1][1] << " " << mat.m[1][2] << " " << mat.m[1][3] << " "
-        << mat.m[2][0] << " " << mat.m[2][1] << " " << mat.m[2][2] << " " << mat.m[2][3] << " "
-        << mat.m[3][0] << " " << mat.m[3][1] << " " << mat.m[3][2] << " " << mat.m[3][3];
-    return oss.str();
+    std::string text;
+    AppendTextFixed(text, &mat.m[0][0], 16, 9);
+    return text;
 }
 
 extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePath, const char* matInfoPath)
 {
     XMLDocument doc;
     doc.LoadFile(filePath);
+    DaeIndex index(doc);
 
     auto collada = doc.FirstChildElement("COLLADA");
     auto asset = collada->FirstChildElement("asset");
@@ -236,43 +307,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
     // below is for adding materials to a mesh cus assimp can only do 1 mat per mesh
 
     // turn polylist block to triangles
-    for (auto mesh = doc.FirstChildElement("COLLADA")
-        ->FirstChildElement("library_geometries")
-        ->FirstChildElement("geometry");
-        mesh;
-        mesh = mesh->NextSiblingElement("geometry")) {
-
-        auto meshElem = mesh->FirstChildElement("mesh");
-        if (!meshElem) continue;
-
-        for (auto polylist = meshElem->FirstChildElement("polylist"); polylist;) {
-            auto next = polylist->NextSiblingElement("polylist");
-
-            // change tag name to triangles
-            auto triangles = doc.NewElement("triangles");
-
-            // copy all attributes
-            const tinyxml2::XMLAttribute* attr = polylist->FirstAttribute();
-            while (attr) {
-                triangles->SetAttribute(attr->Name(), attr->Value());
-                attr = attr->Next();
-            }
-
-            // move children except <vcount>
-            for (auto child = polylist->FirstChildElement(); child;) {
-                auto nextChild = child->NextSiblingElement();
-                if (std::string(child->Name()) != "vcount")
-                    triangles->InsertEndChild(child->DeepClone(&doc));
-                child = nextChild;
-            }
-
-            // replace in tree
-            meshElem->InsertAfterChild(polylist, triangles);
-            meshElem->DeleteChild(polylist);
-
-            polylist = next;
-        }
-    }
+    ConvertPolylistsToTriangles(doc, index);
 
     // load allmaterialtoindices from temp file
     std::vector<std::vector<std::pair<unsigned int, std::vector<unsigned int>>>> allMaterialToIndices;
@@ -305,7 +340,6 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
 
     auto libGeometries = collada->FirstChildElement("library_geometries");
     auto libControllers = collada->FirstChildElement("library_controllers");
-    auto libVisualScenes = collada->FirstChildElement("library_visual_scenes");
 
     size_t meshIdx = 0;
     for (auto geometry = libGeometries->FirstChildElement("geometry"); geometry; geometry = geometry->NextSiblingElement("geometry"), meshIdx++)
@@ -327,6 +361,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
         for (auto input = oldTri->FirstChildElement("input"); input; input = input->NextSiblingElement("input"))
             inputElems.push_back(input->DeepClone(&doc)->ToElement());
 
+        index.Remove(oldTri);
         mesh->DeleteChild(oldTri); // remove old
 
         for (size_t matIdx = 0; matIdx < matCount; matIdx++) {
@@ -337,67 +372,67 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
                 newTri->InsertEndChild(input->DeepClone(&doc));
             auto p = doc.NewElement("p");
             std::string indices;
-            for (auto idx : allMaterialToIndices[meshIdx][matIdx].second)
-                indices += std::to_string(idx) + " ";
-            if (!indices.empty()) indices.pop_back();
+            AppendTextNumbers(indices, allMaterialToIndices[meshIdx][matIdx].second);
             p->SetText(indices.c_str());
             newTri->InsertEndChild(p);
             mesh->InsertEndChild(newTri);
+            index.Add(newTri);
         }
 
         std::string geometryId = geometry->Attribute("id") ? geometry->Attribute("id") : "";
         std::string geomSearchStr = "#" + geometryId;
         std::string ctrlSearchStr = geomSearchStr + "-skin";
 
-        tinyxml2::XMLElement* targetInstance = nullptr;
-
-        for (auto visualScene = libVisualScenes->FirstChildElement("visual_scene"); visualScene; visualScene = visualScene->NextSiblingElement("visual_scene")) {
-            for (auto node = visualScene->FirstChildElement("node"); node; node = node->NextSiblingElement("node")) {
-                //std::cout << "searching for instance_geometry with url=" << geomSearchStr << " or instance_controller with url=" << ctrlSearchStr << "\n";
-                targetInstance = FindInstance(node, geomSearchStr, ctrlSearchStr);
-                if (targetInstance) break;
-            }
-            if (targetInstance) break;
-        }
+        // copied, the loop below edits the index
+        std::vector<tinyxml2::XMLElement*> targetInstances = index.FindInstances(geomSearchStr, ctrlSearchStr);
 
-        if (!targetInstance) {
+        if (targetInstances.empty()) {
             std::cerr << "no instance_controller or instance_geometry found for geometry " << geometryId << "\n";
             continue;
         }
 
-        auto matBind = targetInstance->FirstChildElement("bind_material");
-        if (!matBind) {
-            std::cerr << "no bind_material found\n";
-            continue;
-        }
+        // instanced geometry needs the same materials on every node it's used from
+        for (tinyxml2::XMLElement* targetInstance : targetInstances) {
+            auto matBind = targetInstance->FirstChildElement("bind_material");
+            if (!matBind) {
+                std::cerr << "no bind_material found\n";
+                continue;
+            }
 
-        auto techCommon = matBind->FirstChildElement("technique_common");
-        if (!techCommon) {
-            std::cerr << "no technique_common found in bind_material\n";
-            continue;
-        }
+            auto techCommon = matBind->FirstChildElement("technique_common");
+            if (!techCommon) {
+                std::cerr << "no technique_common found in bind_material\n";
+                continue;
+            }
 
-        auto mat = techCommon->FirstChildElement("instance_material");
-        if (!mat) {
-            std::cerr << "no instance_material found in bind_material\n";
-            continue;
-        }
+            auto mat = techCommon->FirstChildElement("instance_material");
+            if (!mat) {
+                std::cerr << "no instance_material found in bind_material\n";
+                continue;
+            }
 
-        // clone + remap materials
-        std::vector<tinyxml2::XMLElement*> newInstanceMaterials;
-        for (size_t matIdx = 0; matIdx < matCount; matIdx++) {
-            auto block = mat->DeepClone(&doc)->ToElement();
-            std::string symbol = "defaultMaterial" + std::to_string(allMaterialToIndices[meshIdx][matIdx].first);
-            std::string target = "#material_" + std::to_string(allMaterialToIndices[meshIdx][matIdx].first);
-            block->SetAttribute("symbol", symbol.c_str());
-            block->SetAttribute("target", target.c_str());
-            newInstanceMaterials.push_back(block);
-        }
+            // clone + remap materials
+            std::vector<tinyxml2::XMLElement*> newInstanceMaterials;
+            for (size_t matIdx = 0; matIdx < matCount; matIdx++) {
+                auto block = mat->DeepClone(&doc)->ToElement();
+                std::string symbol = "defaultMaterial" + std::to_string(allMaterialToIndices[meshIdx][matIdx].first);
+                std::string target = "#material_" + std::to_string(allMaterialToIndices[meshIdx][matIdx].first);
+                block->SetAttribute("symbol", symbol.c_str());
+                block->SetAttribute("target", target.c_str());
+                newInstanceMaterials.push_back(block);
+            }
 
-        // clear old materials
-        while (techCommon->FirstChild()) techCommon->DeleteChild(techCommon->FirstChild());
-        // insert new ones
-        for (auto m : newInstanceMaterials) techCommon->InsertEndChild(m);
+            // clear old materials
+            while (techCommon->FirstChild()) {
+                if (techCommon->FirstChildElement()) index.Remove(techCommon->FirstChildElement());
+                techCommon->DeleteChild(techCommon->FirstChild());
+            }
+            // insert new ones
+            for (auto m : newInstanceMaterials) {
+                techCommon->InsertEndChild(m);
+                index.Add(m);
+            }
+        }
 
         std::string prettyName = geometryId.size() > 2 && geometryId.compare(geometryId.size() - 2, 2, "_1") == 0
             ? geometryId.substr(0, geometryId.size() - 2) : geometryId;
@@ -462,17 +497,13 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
 
             // only double <p> if TEXCOORD or COLOR exists
             if (hasTexcoord || hasColor) {
-                std::stringstream ss(p->GetText());
-                std::vector<unsigned int> doubled;
-                unsigned int val;
-                while (ss >> val) {
-                    doubled.push_back(val);
-                    doubled.push_back(val);
-                }
-                std::stringstream doubledSS;
-                for (auto v : doubled) doubledSS << v << " ";
-                std::string doubledStr = doubledSS.str();
-                if (!doubledStr.empty()) doubledStr.pop_back();
+                std::vector<unsigned int> values;
+                ParseTextNumbers(p->GetText(), values);
+                std::vector<unsigned int> doubled(values.size() * 2);
+                for (size_t i = 0; i < values.size(); ++i)
+                    doubled[i * 2] = doubled[i * 2 + 1] = values[i];
+                std::string doubledStr;
+                AppendTextNumbers(doubledStr, doubled);
                 p->SetText(doubledStr.c_str());
             }
 
@@ -488,22 +519,14 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
             }
             if (posSourceId.empty()) continue;
 
-            tinyxml2::XMLElement* posSourceElem = nullptr;
-            for (auto source = mesh->FirstChildElement("source"); source; source = source->NextSiblingElement("source")) {
-                if (std::string(source->Attribute("id")) == posSourceId) {
-                    posSourceElem = source;
-                    break;
-                }
-            }
+            tinyxml2::XMLElement* posSourceElem = index.FindById(posSourceId);
             if (!posSourceElem) continue;
 
             auto floatArray = posSourceElem->FirstChildElement("float_array");
             if (!floatArray) continue;
 
-            std::stringstream fss(floatArray->GetText());
             std::vector<float> positions;
-            float f;
-            while (fss >> f) positions.push_back(f);
+            ParseTextNumbers(floatArray->GetText(), positions);
 
             auto technique = posSourceElem->FirstChildElement("technique_common");
             if (!technique) continue;
@@ -524,20 +547,10 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
             std::vector<float> normals;
             int normStride = 0;
             if (!normSourceId.empty()) {
-                tinyxml2::XMLElement* normSourceElem = nullptr;
-                for (auto source = mesh->FirstChildElement("source"); source; source = source->NextSiblingElement("source")) {
-                    if (std::string(source->Attribute("id")) == normSourceId) {
-                        normSourceElem = source;
-                        break;
-                    }
-                }
+                tinyxml2::XMLElement* normSourceElem = index.FindById(normSourceId);
                 if (normSourceElem) {
                     auto normArray = normSourceElem->FirstChildElement("float_array");
-                    if (normArray) {
-                        std::stringstream nss(normArray->GetText());
-                        float nf;
-                        while (nss >> nf) normals.push_back(nf);
-                    }
+                    if (normArray) ParseTextNumbers(normArray->GetText(), normals);
                     auto ntech = normSourceElem->FirstChildElement("technique_common");
                     if (ntech) {
                         auto naccessor = ntech->FirstChildElement("accessor");
@@ -546,10 +559,8 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
                 }
             }
 
-            std::stringstream pss(p->GetText());
             std::vector<unsigned int> indices;
-            unsigned int idx;
-            while (pss >> idx) indices.push_back(idx);
+            ParseTextNumbers(p->GetText(), indices);
 
             int inputCount = 2;
 
@@ -597,10 +608,8 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
                 indices[triIdx] = canonicalIndex;
             }
 
-            std::stringstream outSS;
-            for (auto i : indices) outSS << i << " ";
-            std::string outStr = outSS.str();
-            if (!outStr.empty()) outStr.pop_back();
+            std::string outStr;
+            AppendTextNumbers(outStr, indices);
             p->SetText(outStr.c_str());
         }
     }
@@ -690,149 +699,6 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaeFile_C(const char* filePat
     doc.SaveFile(filePath);
 }
 
-extern "C" __declspec(dllexport) void __cdecl GetDaeNormals_C(const char* filePath) {
-    tinyxml2::XMLDocument doc;
-    if (doc.LoadFile(filePath) != tinyxml2::XML_SUCCESS) {
-        std::cerr << "failed to load dae\n";
-        return;
-    }
-
-    auto libGeometries = doc.FirstChildElement("COLLADA")
-        ->FirstChildElement("library_geometries");
-
-    if (!libGeometries) {
-        std::cerr << "no library_geometries found\n";
-        return;
-    }
-
-    std::vector<std::pair<std::string, std::vector<Vec3>>> meshNormals;
-
-    for (auto geometry = libGeometries->FirstChildElement("geometry"); geometry; geometry = geometry->NextSiblingElement("geometry")) {
-        const char* nameAttr = geometry->Attribute("name");
-        if (!nameAttr) continue;
-
-        std::string rawName(nameAttr);
-        for (size_t i = 0; i < rawName.size(); ++i) {
-            if (rawName[i] == '.')
-                rawName.replace(i, 1, "FBXASC046"), i += sizeof("FBXASC046") - 2;
-        }
-
-        std::string currentMesh = rawName + "Shape";
-
-        auto mesh = geometry->FirstChildElement("mesh");
-        if (!mesh) continue;
-
-        auto triangles = mesh->FirstChildElement("triangles");
-        if (!triangles) continue;
-
-        const char* normalSourceAttr = nullptr;
-        for (auto input = triangles->FirstChildElement("input"); input; input = input->NextSiblingElement("input")) {
-            if (const char* semantic = input->Attribute("semantic")) {
-                if (std::string(semantic) == "NORMAL") {
-                    normalSourceAttr = input->Attribute("source");
-                    break;
-                }
-            }
-        }
-
-        if (!normalSourceAttr || normalSourceAttr[0] != '#') continue;
-
-        std::string normalSourceID = normalSourceAttr + 1;
-
-        tinyxml2::XMLElement* normalsSource = nullptr;
-        for (auto source = mesh->FirstChildElement("source"); source; source = source->NextSiblingElement("source")) {
-            const char* idAttr = source->Attribute("id");
-            if (idAttr && normalSourceID == idAttr) {
-                normalsSource = source;
-                break;
-            }
-        }
-
-        if (!normalsSource) continue;
-
-        auto floatArray = normalsSource->FirstChildElement("float_array");
-        if (!floatArray) continue;
-
-        const char* floatText = floatArray->GetText();
-        if (!floatText) continue;
-
-        std::istringstream iss(floatText);
-        std::vector<float> floats;
-        float val;
-        while (iss >> val) floats.push_back(val);
-
-        std::vector<Vec3> normals;
-        for (size_t i = 0; i + 2 < floats.size(); i += 3)
-            normals.push_back(Vec3{ floats[i], floats[i + 1], floats[i + 2] });
-
-        meshNormals.emplace_back(currentMesh, std::move(normals));
-    }
-
-    std::string outputName = std::string(filePath).substr(0, std::string(filePath).find_last_of('.')) + "_normals.txt";
-    std::ofstream py(outputName.c_str());
-    if (!py.is_open()) {
-        std::cerr << "couldn't write normals txt file\n";
-        return;
-    }
-
-	// write the python script to apply normals in Maya
-    py << "import maya.api.OpenMaya as om\n";
-    py << "import maya.utils\n\n";
-
-    int meshIndex = 0;
-    for (const auto& meshPair : meshNormals) {
-        const std::string& mesh = meshPair.first;
-        const std::vector<Vec3>& normals = meshPair.second;
-
-        py << "def apply_normals_" << meshIndex << "():\n";
-        py << "    meshName = \"" << mesh << "\"\n";
-        py << "    normalsList = [\n        ";
-        for (size_t j = 0; j < normals.size(); ++j) {
-            const Vec3& n = normals[j];
-            py << "(" << n.x << ", " << n.y << ", " << n.z << ")";
-            if (j + 1 < normals.size()) py << ", ";
-            if ((j + 1) % 5 == 0) py << "\n        ";
-        }
-        py << "\n    ]\n";
-        py << "    try:\n";
-        py << "        sel = om.MSelectionList()\n";
-        py << "        sel.add(meshName)\n";
-        py << "        dagPath = sel.getDagPath(0)\n";
-        py << "        fnMesh = om.MFnMesh(dagPath)\n";
-        py << "        normals = [om.MVector(x, y, z) for (x, y, z) in normalsList]\n";
-        py << "        vertexIndices = list(range(len(normals)))\n";
-        py << "        fnMesh.setVertexNormals(normals, vertexIndices)\n";
-        py << "        print(f\"done {meshName}\")\n";
-        if (meshIndex + 1 < (int)meshNormals.size()) {
-            py << "        maya.utils.executeDeferred(apply_normals_" << (meshIndex + 1) << ")\n";
-        }
-        else {
-            py << "        maya.utils.executeDeferred(apply_normals_" << (meshIndex + 1) << ")\n"; // call the dummy one
-        }
-        py << "    except Exception as e:\n";
-        py << "        print(f\"error applying to {meshName}: {e}\")\n";
-        py << "\n";
-        meshIndex++;
-    }
-
-    // dummy last function to finalize and resize joints
-    py << "def apply_normals_" << meshIndex << "():\n";
-    py << "    print('All normals applied!')\n";
-    py << "    import maya.cmds as cmds\n";
-    py << "    joints = cmds.ls(type='joint')\n";
-    py << "    for j in joints:\n";
-    py << "        if cmds.attributeQuery('radius', node=j, exists=True):\n";
-    py << "            cmds.setAttr(f\"{j}.radius\", 0.3)\n";
-    py << "\n";
-
-    // kickoff
-    py << "maya.utils.executeDeferred(apply_normals_0)\n";
-
-    py.close();
-
-    std::cout << "\nMaya py script to import normals after dae import: " << outputName << " <- run that in script editor!\n";
-}
-
 void ProcessNode(tinyxml2::XMLDocument& doc, tinyxml2::XMLElement* node, const std::unordered_set<std::string>& meshNameSet) {
     using namespace tinyxml2;
 
@@ -972,36 +838,6 @@ void MergeSuffixMeshes(XMLElement* node, const std::unordered_set<std::string>&
     }
 }
 
-tinyxml2::XMLElement* FindNodeByIdRecursive(tinyxml2::XMLElement* parent, const std::string& targetId) {
-    for (tinyxml2::XMLElement* node = parent->FirstChildElement("node"); node; node = node->NextSiblingElement("node")) {
-        const char* id = node->Attribute("id");
-        if (id && targetId == id)
-            return node;
-
-        // search child nodes recursively
-        tinyxml2::XMLElement* found = FindNodeByIdRecursive(node, targetId);
-        if (found)
-            return found;
-    }
-    return nullptr;
-}
-
-// helper to find node by sid and return its 'name'
-std::string FindNodeNameBySID(tinyxml2::XMLElement* parent, const std::string& sid) {
-    for (tinyxml2::XMLElement* node = parent->FirstChildElement("node"); node; node = node->NextSiblingElement("node")) {
-        const char* thisSid = node->Attribute("sid");
-        if (thisSid && sid == thisSid) {
-            const char* name = node->Attribute("name");
-            if (name) return name;
-        }
-
-        // recurse into child nodes
-        std::string result = FindNodeNameBySID(node, sid);
-        if (!result.empty()) return result;
-    }
-    return {};
-}
-
 extern "C" __declspec(dllexport) void __cdecl GetDaeBoneNames_C(const char* filePath, const char* meshName, char** outputBones, int maxBones, int* outCount)
 {
     if (!filePath || !meshName || !outputBones || !outCount) return;
@@ -1012,6 +848,7 @@ extern "C" __declspec(dllexport) void __cdecl GetDaeBoneNames_C(const char* file
         printf("failed to load dae: %s\n", filePath);
         return;
     }
+    DaeIndex index(doc);
 
     auto* collada = doc.FirstChildElement("COLLADA");
     if (!collada) {
@@ -1081,14 +918,7 @@ extern "C" __declspec(dllexport) void __cdecl GetDaeBoneNames_C(const char* file
         return;
     }
 
-    tinyxml2::XMLElement* jointSource = nullptr;
-    for (auto* source = skin->FirstChildElement("source"); source; source = source->NextSiblingElement("source")) {
-        const char* id = source->Attribute("id");
-        if (id && std::string(id) == jointSourceId) {
-            jointSource = source;
-            break;
-        }
-    }
+    tinyxml2::XMLElement* jointSource = index.FindById(jointSourceId);
 
     if (!jointSource) {
         //printf("joint source not found: %s\n", jointSourceId);
@@ -1101,17 +931,16 @@ extern "C" __declspec(dllexport) void __cdecl GetDaeBoneNames_C(const char* file
         return;
     }
 
-    std::istringstream iss(nameArray->GetText());
-    std::string bone;
     int count = 0;
-    while (iss >> bone && count < maxBones) {
-        strncpy_s(outputBones[count], 256, bone.c_str(), _TRUNCATE);
+    ForEachTextToken(nameArray->GetText(), [&](std::string_view bone) {
+        if (count >= maxBones) return;
+        strncpy_s(outputBones[count], 256, bone.data(), std::min<size_t>(bone.size(), 255));
         ++count;
-    }
+    });
 
     for (int i = 0; i < count; ++i) {
         std::string original = outputBones[i];
-        std::string newName = FindNodeNameBySID(visualScene, original);
+        std::string newName = index.FindNodeNameBySID(original);
         if (!newName.empty()) {
             strncpy_s(outputBones[i], 256, newName.c_str(), _TRUNCATE);
         }
@@ -1450,6 +1279,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
         printf("[dae-scan] failed to load DAE\n");
         return;
     }
+    DaeIndex index(doc);
 
     tinyxml2::XMLElement* root = doc.RootElement();
     if (!root) {
@@ -1468,43 +1298,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
     }
 
     // turn polylist block to triangles
-    for (auto mesh = doc.FirstChildElement("COLLADA")
-        ->FirstChildElement("library_geometries")
-        ->FirstChildElement("geometry");
-        mesh;
-        mesh = mesh->NextSiblingElement("geometry")) {
-
-        auto meshElem = mesh->FirstChildElement("mesh");
-        if (!meshElem) continue;
-
-        for (auto polylist = meshElem->FirstChildElement("polylist"); polylist;) {
-            auto next = polylist->NextSiblingElement("polylist");
-
-            // change tag name to triangles
-            auto triangles = doc.NewElement("triangles");
-
-            // copy all attributes
-            const tinyxml2::XMLAttribute* attr = polylist->FirstAttribute();
-            while (attr) {
-                triangles->SetAttribute(attr->Name(), attr->Value());
-                attr = attr->Next();
-            }
-
-            // move children except <vcount>
-            for (auto child = polylist->FirstChildElement(); child;) {
-                auto nextChild = child->NextSiblingElement();
-                if (std::string(child->Name()) != "vcount")
-                    triangles->InsertEndChild(child->DeepClone(&doc));
-                child = nextChild;
-            }
-
-            // replace in tree
-            meshElem->InsertAfterChild(polylist, triangles);
-            meshElem->DeleteChild(polylist);
-
-            polylist = next;
-        }
-    }
+    ConvertPolylistsToTriangles(doc, index);
 
     // Build map: geometryId -> per-vertex bone weight map (vertexIndex -> map<boneName,weight>)
     std::unordered_map<std::string, std::unordered_map<unsigned int, std::unordered_map<std::string, float>>> boneWeightsPerGeometry;
@@ -1548,42 +1342,24 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
 
         // parse joint names from jointSourceId (a <source> containing a Name_array or similar)
         std::vector<std::string> jointNames;
-        if (!jointSourceId.empty()) {
-            for (tinyxml2::XMLElement* s = skin->FirstChildElement("source"); s; s = s->NextSiblingElement("source")) {
-                const char* sid = s->Attribute("id");
-                if (!sid) continue;
-                if (std::string(sid) != jointSourceId) continue;
-                tinyxml2::XMLElement* nameArray = s->FirstChildElement("Name_array");
-                if (!nameArray) nameArray = s->FirstChildElement("name_array"); // fallback
-                if (!nameArray) continue;
-                const char* namesText = nameArray->GetText();
-                if (!namesText) continue;
-                std::stringstream ss(namesText);
-                std::string tok;
-                while (ss >> tok) {
-                    jointNames.push_back(tok);
-                }
+        if (tinyxml2::XMLElement* s = index.FindById(jointSourceId)) {
+            tinyxml2::XMLElement* nameArray = s->FirstChildElement("Name_array");
+            if (!nameArray) nameArray = s->FirstChildElement("name_array"); // fallback
+            const char* namesText = nameArray ? nameArray->GetText() : nullptr;
+            if (namesText) {
+                ForEachTextToken(namesText, [&](std::string_view tok) { jointNames.emplace_back(tok); });
                 //printf("[dae-scan]   parsed %zu joint names\n", jointNames.size());
-                break;
             }
         }
 
         // parse weights floats from weightSourceId
         std::vector<float> weightValues;
-        if (!weightSourceId.empty()) {
-            for (tinyxml2::XMLElement* s = skin->FirstChildElement("source"); s; s = s->NextSiblingElement("source")) {
-                const char* sid = s->Attribute("id");
-                if (!sid) continue;
-                if (std::string(sid) != weightSourceId) continue;
-                tinyxml2::XMLElement* fa = s->FirstChildElement("float_array");
-                if (!fa) continue;
-                const char* ft = fa->GetText();
-                if (!ft) continue;
-                std::stringstream ss(ft);
-                float fv;
-                while (ss >> fv) weightValues.push_back(fv);
+        if (tinyxml2::XMLElement* s = index.FindById(weightSourceId)) {
+            tinyxml2::XMLElement* fa = s->FirstChildElement("float_array");
+            const char* ft = fa ? fa->GetText() : nullptr;
+            if (ft) {
+                ParseTextNumbers(ft, weightValues);
                 //printf("[dae-scan]   parsed %zu weight floats\n", weightValues.size());
-                break;
             }
         }
 
@@ -1596,21 +1372,11 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
         }
         std::vector<int> vcounts;
         {
-            const char* vcText = vcountElem->GetText();
-            if (vcText) {
-                std::stringstream ssv(vcText);
-                int vi;
-                while (ssv >> vi) vcounts.push_back(vi);
-            }
+            ParseTextNumbers(vcountElem->GetText(), vcounts);
         }
         std::vector<unsigned int> vvals;
         {
-            const char* vText = vElem->GetText();
-            if (vText) {
-                std::stringstream ssv(vText);
-                unsigned int vv;
-                while (ssv >> vv) vvals.push_back(vv);
-            }
+            ParseTextNumbers(vElem->GetText(), vvals);
         }
         //printf("[dae-scan]  vertex_weights vcount entries=%zu, v tokens=%zu\n", vcounts.size(), vvals.size());
 
@@ -1691,13 +1457,8 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
                 printf("[dae-scan]   <triangles> has no <p> content, skipping this block\n");
                 continue;
             }
-            std::string ptext = pElem->GetText();
             std::vector<unsigned int> pvals;
-            {
-                std::stringstream ssp(ptext);
-                unsigned int v;
-                while (ssp >> v) pvals.push_back(v);
-            }
+            ParseTextNumbers(pElem->GetText(), pvals);
             size_t numbersPerTri = (size_t)triInputCount * 3u;
             if (numbersPerTri == 0) {
                 printf("[dae-scan]   bad input count, skipping\n");
@@ -1888,10 +1649,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
                 //printf("[patch] triangles block missing <p> content, skipping\n");
                 continue;
             }
-            std::string ptext = pElem->GetText();
-            std::stringstream ssp(ptext);
-            unsigned int idx;
-            while (ssp >> idx) block.pIndices.push_back(idx);
+            ParseTextNumbers(pElem->GetText(), block.pIndices);
 
             unsigned int triCount = (unsigned int)(block.pIndices.size() / (block.inputCount * 3));
             for (unsigned int i = 0; i < triCount; ++i) block.triIndices.push_back(i);
@@ -1967,6 +1725,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
             if (!parentMesh) continue;
 
             // delete original block
+            index.Remove(origBlock);
             parentMesh->DeleteChild(origBlock);
 
             for (size_t gi : groupIndices) {
@@ -1991,11 +1750,8 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
                         printf("[patch] warning: index out of pIndices range\n");
                         continue;
                     }
-                    for (int k = 0; k < inputCount * 3; ++k) {
-                        ptext += std::to_string(blockInfo->pIndices[baseIdx + k]) + " ";
-                    }
+                    AppendTextNumbers(ptext, &blockInfo->pIndices[baseIdx], inputCount * 3);
                 }
-                if (!ptext.empty()) ptext.pop_back();
 
                 XMLElement* newTri = doc.NewElement("triangles");
                 if (!materialName.empty()) newTri->SetAttribute("material", materialName.c_str());
@@ -2012,6 +1768,7 @@ extern "C" __declspec(dllexport) void __cdecl PatchDaePreImport_C(const char* da
                 newTri->InsertEndChild(pElem);
 
                 parentMesh->InsertEndChild(newTri);
+                index.Add(newTri);
             }
         }
     }